@@ -7,12 +7,27 @@
 #include "ssd1306.h"
 #include "hardware/i2c.h"
 #include "hardware/pwm.h"
-#include "notes.h"
+#include "song.h"
+#include "songs.h"
+#include "screens.h"
 #include "hardware/adc.h"
+#include "scheduler.h"
+#include "play_audio.h"
+#include "tone.h"
+#include "buttons.h"
+#include "joystick.h"
+#include "display.h"
+#include "attendance.h"
+#include "trace.h"
+#include "fsm.h"
+#include "kiosk.h"
+#include "power.h"
+#include "export.h"
+#include "boot.h"
 
 // Declaração de funções
-void restart_system(uint8_t *buf, struct render_area *frame_area);  // Reinicia o sistema
 void play_alert_sound(uint pin);  // Toca um som de alerta no buzzer
+void stop_alert_sound(uint pin);  // Interrompe o alerta sonoro
 
 // Definição dos pinos utilizados
 const uint I2C_SDA_PIN = 14;  // Pino SDA do I2C
@@ -25,185 +40,182 @@ const uint LEDvr = 12;        // Pino para o LED 12 (LED de presença)
 const uint LEDa = 11;         // Pino para o LED 11 (LED do botão A)
 const uint LEDv = 13;         // Pino para o LED 13 (LED de confirmação)
 
-// Configurações de PWM (modulação por largura de pulso)
+// Configurações dos tons: divisor de clock (as notas de notes.h contam ciclos
+// de clk_sys / 16) e divisão do período que fica em nível alto (volume)
 const float DIVISOR_CLK_PWM = 16.0;      
-const uint16_t PERIOD = 2000;            
 const uint16_t MAX_WRAP_DIV_BUZZER = 16; 
 const uint16_t MIN_WRAP_DIV_BUZZER = 2;  
 
-// Estados do botão, para controle de debounce
-typedef enum {
-    IDLE, DEBOUNCING_A, RELEASE_A, DEBOUNCING_B, RELEASE_B, ACTION_A, ACTION_B      
-} state_button;
+// Período da tarefa de leitura dos botões e do joystick
+const uint32_t INPUT_PERIOD_MS = 1;
+
+// Melodia após cada confirmação de presença. Desligada por padrão: dura 68 s e,
+// tocando, conta como interação, o que adia o modo ocioso. Pelo console, 'm'
+// toca ou interrompe a melodia a qualquer momento.
+#ifndef CONFIRM_MELODY
+#define CONFIRM_MELODY 0
+#endif
 
 // Variáveis globais
 uint16_t wrap_div_buzzer = 8;  // Valor padrão de divisão do buzzer
 bool is_buzzer_a_playing = true; // Flag para controle do buzzer A
 
-// Função que toca uma nota no buzzer
+// Alerta sonoro: 3 notas de 500 ms, repetidas 3 vezes. A última nota segue
+// soando durante a pausa de 500 ms entre as repetições.
+const uint16_t alert_words[] = {
+    SONG_TEMPO(2000), SONG_NOTE(PITCH_C4, 4), SONG_NOTE(PITCH_E4, 4), SONG_NOTE(PITCH_G4, 2), SONG_END
+};
+const song_t alert_song = {alert_words, 3};
+
+// Harmonia do alerta no buzzer B, uma terça acima: os dois formam acordes
+const uint16_t alert_harmony_words[] = {
+    SONG_TEMPO(2000), SONG_NOTE(PITCH_E4, 4), SONG_NOTE(PITCH_G4, 4), SONG_NOTE(PITCH_B4, 2), SONG_END
+};
+const song_t alert_harmony = {alert_harmony_words, 3};
+
+// Melodia de songs/melody.inc, tocada em segundo plano (CONFIRM_MELODY ou 'm')
+const song_t melody_song = {song_melody, 1};
+
+// Função que toca uma nota no buzzer: a voz do pino recebe o período e o
+// tempo em nível alto, que define o volume
 void play_note(uint pin, uint16_t wrap) {
-    int slice = pwm_gpio_to_slice_num(pin);  // Obtém o número do "slice" do pino
-    pwm_set_wrap(slice, wrap);  // Define o valor do wrap
-    pwm_set_gpio_level(pin, wrap / wrap_div_buzzer);  // Define o nível do pino
-    pwm_set_enabled(slice, true);  // Habilita o PWM
+    tone_set(tone_voice(pin), wrap, wrap / wrap_div_buzzer);
 }
 
 // Função para silenciar o buzzer
 void play_rest(uint pin) {
-    int slice = pwm_gpio_to_slice_num(pin);
-    pwm_set_enabled(slice, false);  // Desativa o PWM (som)
+    tone_set(tone_voice(pin), 0, 0);
 }
 
-// Função que desenha texto no display
-void draw_text_display(const char *text[], uint8_t *buf, struct render_area *frame_area) {
-    int y = 0;
-    for (uint i = 0; i < 4; i++) { 
-        WriteString(buf, 5, y, (char *)text[i]);  // Escreve o texto no buffer
-        y += 8;  // Incrementa o Y para o próximo texto
-    }
-    render(buf, frame_area);  // Renderiza o conteúdo do buffer
-}
-
-// Função que lê o estado dos botões com debounce
-void read_buttons(uint8_t *buf, struct render_area *frame_area) {
-    static state_button s = IDLE;    
-    static uint cnt = 0;              // Contador para o debounce
-    const uint DEBOUNCE_CYCLES = 50;  // Tempo de debounce
-
-    const char *textBTN_A[] = {
-        "   PRESENCA    ",
-        "  CONFIRMADA   ",
-        "    PRESS B    ",
-        "   (COLETE)    "
-    };
-
-    const char *textBTN_B[] = {                         
-        "   PRONTO      ",
-        "  DADOS SENDO  ",
-        "  REINICIADOS  ",
-        "    AGUARDE    "
-    };
-
-    switch (s) {
-        case IDLE:  // Estado inicial
-            if (gpio_get(BUTTON_A) == 0) {  
-                draw_text_display(textBTN_A, buf, frame_area);  // Exibe mensagem do botão A
-                s = DEBOUNCING_A;  // Muda para estado de debounce do botão A
-            }          
-            if (gpio_get(BUTTON_B) == 0) { 
-                draw_text_display(textBTN_B, buf, frame_area);  // Exibe mensagem do botão B
-                s = DEBOUNCING_B;  // Muda para estado de debounce do botão B
-            }          
-            cnt = 0;  // Reseta o contador de debounce
-            break;
-        case DEBOUNCING_A:  // Espera o botão A ser liberado
-            if (gpio_get(BUTTON_A) == 0) {
-                cnt++;  // Conta o tempo de debounce
-                if (cnt > DEBOUNCE_CYCLES) {
-                    cnt = 0;
-                    s = RELEASE_A;  // Quando o botão A for pressionado, muda para RELEASE_A
-                }
-            } else {
-                s = IDLE;  // Se o botão A foi solto, volta para o estado IDLE
-            }
-            break;
-        case DEBOUNCING_B:  // Espera o botão B ser liberado
-            if (gpio_get(BUTTON_B) == 0) {
-                cnt++;  // Conta o tempo de debounce
-                if (cnt > DEBOUNCE_CYCLES) {
-                    cnt = 0;
-                    s = RELEASE_B;  // Quando o botão B for pressionado, muda para RELEASE_B
-                }
-            } else {
-                s = IDLE;  // Se o botão B foi solto, volta para o estado IDLE
-            }
-            break;
-        case RELEASE_A:  // Quando o botão A for solto
-            if (gpio_get(BUTTON_A) == 1)
-                s = ACTION_A;  // Muda para ação do botão A
-            break;
-        case RELEASE_B:  // Quando o botão B for solto
-            if (gpio_get(BUTTON_B) == 1)
-                s = ACTION_B;  // Muda para ação do botão B
-            break;
-        case ACTION_A:  // Ação associada ao botão A
-            s = IDLE;
-            gpio_put(LEDvr, 0);  // Desliga o LED 12
-            gpio_put(LEDv, 0);    // Desliga o LED 13
-            gpio_put(LEDa, 1);   // Acende o LED 11
-            play_rest(BUZZER_A); // Desliga o buzzer A
-            is_buzzer_a_playing = false;  // Desliga o buzzer A
-            break;
-        case ACTION_B:  // Ação associada ao botão B
-            s = IDLE;
-            gpio_put(LEDa, 0);   // Desliga o LED 11
-            gpio_put(LEDvr, 1);  // Acende o LED 12
-            play_rest(BUZZER_A);  
-            is_buzzer_a_playing = false; 
+// Tarefa que grava na flash os registros de presença pendentes
+void attendance_sync_task(void *arg) {
+    attendance_sync();
+}
 
-            sleep_ms(5000);  // Espera 5 segundos antes de reiniciar o sistema
+// Registra um evento de presença. A gravação é adiada por 1 segundo para juntar
+// registros feitos em sequência numa única programação de página.
+void record_attendance(uint8_t type) {
+    static sched_id sync_timer = -1;
 
-            restart_system(buf, frame_area);  // Chama a função que reinicializa o sistema
+    attendance_append(type);
+    sched_cancel(sync_timer);
+    sync_timer = sched_after_ms(1000, attendance_sync_task, NULL);
+}
 
-            play_alert_sound(BUZZER_A);  // Toca novamente o alerta
-            is_buzzer_a_playing = true;
+// As mensagens das etapas do fluxo são telas prontas, rasterizadas na
+// compilação a partir de screens/kiosk.txt (screens.h)
 
-            gpio_put(LEDvr, 1);  // Acende o LED 12 após reiniciar
-            break;
-        default:
-            s = IDLE;  // Reseta o estado para IDLE
-            cnt = 0;  // Reseta o contador de debounce
-    }
+// Ações das máquinas de estado
+
+void show_button_a(fsm *m) {
+    display_screen(screen_button_a);  // Exibe mensagem do botão A
 }
 
-// Função para reiniciar o sistema e renderizar o display corretamente
-void restart_system(uint8_t *buf, struct render_area *frame_area) {
-    SSD1306_init();  // Inicializa o display SSD1306
+void show_button_b(fsm *m) {
+    display_screen(screen_button_b);  // Exibe mensagem do botão B
+}
 
-    memset(buf, 0, SSD1306_BUF_LEN);  // Limpa o buffer
-    render(buf, frame_area);  // Renderiza o conteúdo do buffer
+// Presença confirmada com o botão A
+void confirm_presence(fsm *m) {
+    gpio_put(LEDvr, 0);  // Desliga o LED 12
+    gpio_put(LEDv, 0);    // Desliga o LED 13
+    gpio_put(LEDa, 1);   // Acende o LED 11
+    stop_alert_sound(BUZZER_A); // Desliga o buzzer A
+    is_buzzer_a_playing = false;  // Desliga o buzzer A
+#if CONFIRM_MELODY
+    sequencer_play(BUZZER_A, &melody_song, SEQ_PRIO_BACKGROUND);  // Música de confirmação, sem bloquear
+#endif
+    record_attendance(ATTENDANCE_PRESENCE);  // Registra a presença na flash
+}
 
-    // Exibe a mensagem de reinício
-    const char *restart_text[] = {
-        "  OBRIGADO ATÉ  ",
-        "  O PROXIMO     ",
-        "   HORARIO      ",
-        "               "
-    };
-    draw_text_display(restart_text, buf, frame_area);
+// Sessão encerrada com o botão B; o reinício vem pelos tempos limite dos estados
+void reset_session(fsm *m) {
+    gpio_put(LEDa, 0);   // Desliga o LED 11
+    gpio_put(LEDvr, 1);  // Acende o LED 12
+    stop_alert_sound(BUZZER_A);
+    sequencer_stop(SEQ_PRIO_BACKGROUND);
+    record_attendance(ATTENDANCE_RESET);  // Encerra a sessão no registro
+    is_buzzer_a_playing = false;
+}
 
-    sleep_ms(5000);  // Aguarda 5 segundos antes de reiniciar o sistema
+// Reinicializa o display e mostra a mensagem de reinício
+void restart_system(fsm *m) {
+    display_reset();  // Inicializa o display SSD1306
+    display_screen(screen_restart);  // Quadro inteiro: dispensa limpar a tela antes
 }
 
-// Função para tocar o alerta sonoro (3 notas)
-void play_alert_sound(uint pin) {
-    uint melody_alert[] = {NOTE_C4, NOTE_E4, NOTE_G4};  // Melodia de 3 notas
-    uint durations_alert[] = {500, 500, 500};           // Duração de 500 ms para cada nota
-    int repeat_count = 0;  // Contador de repetições
-
-    while (repeat_count < 3) {  // Repetir a melodia 3 vezes
-        for (int i = 0; i < 3; i++) {
-            play_note(pin, melody_alert[i]);  // Toca cada nota
-            sleep_ms(durations_alert[i]);  // Espera a duração de cada nota
+// Conclui o reinício, depois que a mensagem ficou 5 segundos na tela
+void restart_done(fsm *m) {
+    play_alert_sound(BUZZER_A);  // Toca novamente o alerta
+    is_buzzer_a_playing = true;
+    gpio_put(LEDvr, 1);  // Acende o LED 12 após reiniciar
+}
+
+void joystick_led_on(fsm *m) {
+    gpio_put(LEDvr, 1); // Acende LED 12 (LEDvr) quando o joystick é movido
+}
+
+void joystick_led_off(fsm *m) {
+    gpio_put(LEDvr, 0);  // Desliga LED 12 após o botão A
+}
+
+// Condição do joystick: o LED apaga quando o botão A está solto
+bool button_a_up(const fsm *m, uint32_t time_us) {
+    return !buttons_is_pressed(BUTTON_A);
+}
+
+fsm kiosk, joystick;
+
+// Com a instrumentação ligada, cada transição sai pela USB:
+//   F <máquina> <origem> <evento> <destino> <instante_us>
+// um registro que sim/tests/test_fsm reproduz nas tabelas de kiosk.c
+void log_transition(const fsm *m, uint8_t from, uint8_t event, uint8_t to, uint32_t time_us) {
+    if (trace_on)
+        printf("F %s %s %s %s %lu\n", m->def->name, fsm_state_name(m, from), fsm_event_name(m, event),
+               fsm_state_name(m, to), (unsigned long)time_us);
+}
+
+// Função que lê os botões: entrega à máquina os eventos gerados por interrupção
+// e os tempos limite vencidos
+void read_buttons() {
+    button_event ev;
+    uint32_t t0 = TRACE_BEGIN();
+
+    while (buttons_get_event(&ev)) {
+        power_activity(ev.time_us);  // Mede a latência desde a borda, se estava ocioso
+        if (ev.type == BUTTON_PRESS || ev.type == BUTTON_RELEASE) {
+            bool press = ev.type == BUTTON_PRESS;
+            if (ev.pin == BUTTON_A)
+                fsm_dispatch(&kiosk, press ? EV_A_PRESS : EV_A_RELEASE, ev.time_us);
+            else if (ev.pin == BUTTON_B)
+                fsm_dispatch(&kiosk, press ? EV_B_PRESS : EV_B_RELEASE, ev.time_us);
         }
-        repeat_count++;  // Incrementa o contador de repetições
-        sleep_ms(500);  // Pausa entre as repetições
     }
-    play_rest(pin);  // Desliga o buzzer
+    fsm_poll(&kiosk, time_us_32());
+    TRACE_END(READ_BUTTONS, t0);
 }
 
-// Função para configurar o áudio e os pinos
-void setup_audio() {
-    uint slice;
-    stdio_init_all();
+// Função para tocar o alerta sonoro (3 notas), em segundo plano pelo sequenciador,
+// com a harmonia no outro buzzer
+void play_alert_sound(uint pin) {
+    uint32_t t0 = TRACE_BEGIN();
+    sequencer_play(pin, &alert_song, SEQ_PRIO_ALERT);
+    sequencer_play(pin == BUZZER_A ? BUZZER_B : BUZZER_A, &alert_harmony, SEQ_PRIO_ALERT);
+    TRACE_END(ALERT_SOUND, t0);
+}
 
+// Interrompe o alerta sonoro nos dois buzzers; uma música de fundo, se houver, continua
+void stop_alert_sound(uint pin) {
+    sequencer_stop(SEQ_PRIO_ALERT);
+}
+
+// Configura os LEDs, os botões e o joystick
+void setup_inputs() {
     gpio_set_function(LEDv, GPIO_FUNC_SIO);
     gpio_set_function(LEDa, GPIO_FUNC_SIO);
     gpio_set_function(LEDvr, GPIO_FUNC_SIO);
     gpio_set_function(BUTTON_A, GPIO_FUNC_SIO);
     gpio_set_function(BUTTON_B, GPIO_FUNC_SIO);
-    gpio_set_function(BUZZER_A, GPIO_FUNC_PWM);
-    gpio_set_function(BUZZER_B, GPIO_FUNC_PWM);
 
     gpio_set_dir(LEDv, GPIO_OUT);
     gpio_set_dir(LEDa, GPIO_OUT);
@@ -214,48 +226,155 @@ void setup_audio() {
     gpio_pull_up(BUTTON_A);  // Ativa o pull-up interno no botão A
     gpio_pull_up(BUTTON_B);  // Ativa o pull-up interno no botão B
 
+    const uint button_pins[] = {BUTTON_A, BUTTON_B};
+    buttons_init(button_pins, count_of(button_pins));  // Eventos dos botões por interrupção
+
+    joystick_init();  // ADC e DMA do joystick configurados uma única vez
+
     gpio_put(LEDv, 1);  // Acende o LED 13 (LEDv) ao iniciar
     gpio_put(LEDa, 0);  // Desliga o LED 11
+}
 
-    slice = pwm_gpio_to_slice_num(BUZZER_A);  // Obtém o slice do buzzer
-    pwm_set_clkdiv(slice, DIVISOR_CLK_PWM);  // Define o divisor de clock
-    pwm_set_wrap(slice, PERIOD);  // Define o valor do wrap do PWM
-    pwm_set_enabled(slice, true);  // Habilita o PWM
+// Configura os buzzers e toca o alerta de início
+void setup_audio() {
+    const uint buzzer_pins[] = {BUZZER_A, BUZZER_B};
+    tone_init(buzzer_pins, count_of(buzzer_pins), DIVISOR_CLK_PWM);  // Uma voz por buzzer, em silêncio
 
     play_alert_sound(BUZZER_A);  // Toca o som de alerta ao ligar
     is_buzzer_a_playing = true;
 }
 
-// Função para ler os valores do joystick (não está sendo usada no código atual)
+// Função para ler o joystick: o ADC já amostra continuamente via DMA, aqui só
+// é consultado o valor filtrado (média móvel, com histerese em torno do centro)
 bool read_joystick() {
-    uint joystick_x, joystick_y;
+    uint32_t t0 = TRACE_BEGIN();
+    bool moved = joystick_moved();  // true se o joystick for movido
+    TRACE_END(READ_JOYSTICK, t0);
+    return moved;
+}
+
+// Tarefa periódica do display: avança envios assíncronos pendentes
+void display_task(void *arg) {
+    display_poll();
+}
 
-    // Inicializa ADC
-    adc_init();
-    adc_gpio_init(26);  // GPIO26 para eixo X
-    adc_gpio_init(27);  // GPIO27 para eixo Y
+// Uma etapa do fluxo em andamento ou música tocando conta como interação
+bool kiosk_busy() {
+    return kiosk.state != ST_IDLE || joystick.state != ST_JOY_IDLE ||
+           sequencer_is_playing(SEQ_PRIO_BACKGROUND) || sequencer_is_playing(SEQ_PRIO_ALERT) ||
+           export_active();
+}
 
-    // Lê os valores dos eixos
-    adc_select_input(0);
-    joystick_x = adc_read();
+// Tarefa periódica de entrada: joystick e botões
+void input_task(void *arg) {
+    uint32_t now = time_us_32();
 
-    adc_select_input(1);
-    joystick_y = adc_read();
+    boot_mark(BOOT_READY);  // Primeira leitura: a partir daqui os botões valem
 
-    // Se o joystick for movido (valores diferentes do centro)
-    if (joystick_x < 2000 || joystick_x > 4000 || joystick_y < 2000 || joystick_y > 4000) {
-        return true;  // Retorna true se o joystick for movido
+    if (read_joystick()) {
+        power_activity(now);  // Acorda do modo ocioso, se for o caso
+        fsm_dispatch(&joystick, EV_JOYSTICK, now);
     }
-    return false;  // Caso contrário, retorna false
+    fsm_dispatch(&joystick, EV_TICK, now);
+    if (joystick.state != ST_JOY_HOLD)  // Em HOLD aguarda o botão A, sem bloquear as outras tarefas
+        read_buttons();  // Continua a leitura dos botões
+
+    power_poll(kiosk_busy());  // Apaga o display e reduz o clock após o tempo sem uso
 }
 
-// Função principal
-int main() {
-    stdio_init_all();  // Inicializa o sistema de entrada e saída
+// Tarefa periódica de instrumentação: atende os comandos recebidos pela USB
+void trace_task(void *arg) {
+    trace_poll();
+}
+
+// Tarefa da exportação: volta logo se a FIFO da USB aceitou dados, ou em 1 ms
+// se estava cheia, até o quadro de fim
+void export_task(void *arg) {
+    switch (export_poll()) {
+        case EXPORT_SENDING:
+            sched_post(export_task, NULL);
+            break;
+        case EXPORT_WAITING:
+            sched_after_ms(1, export_task, NULL);
+            break;
+        default:
+            break;
+    }
+}
+
+// Caracteres do console que não são do trace: melodia e comando de exportação
+void console_input(int ch) {
+    if (ch == 'm') {
+        power_activity(time_us_32());  // Ocioso, acorda antes: a nota sai no clock normal
+        if (sequencer_is_playing(SEQ_PRIO_BACKGROUND))
+            sequencer_stop(SEQ_PRIO_BACKGROUND);
+        else
+            sequencer_play(BUZZER_A, &melody_song, SEQ_PRIO_BACKGROUND);
+        return;
+    }
+    if (export_command(ch))
+        sched_post(export_task, NULL);
+}
+
+// Relatórios acrescentados ao comando 's'
+void print_reports() {
+    boot_print_report();  // Instante de cada etapa do boot
+    display_print_report();  // Latência dos comandos do display
+    buttons_print_report();  // Latência entre a borda e a leitura dos botões
+    power_print_report();  // Residência e latência de despertar
+    export_print_report();  // Última exportação do registro de presença
+}
 
-    setup_audio();  // Configura o áudio e os pinos
+sched_id input_timer = -1, display_timer = -1;
 
-    // Configura o display SSD1306
+// Ocioso, as entradas e o display são atendidos a cada POWER_IDLE_POLL_MS, e o
+// núcleo dorme entre uma leitura e outra
+void power_changed(power_state from, power_state to) {
+    uint32_t input_ms = to == POWER_IDLE ? POWER_IDLE_POLL_MS : INPUT_PERIOD_MS;
+    uint32_t display_ms = to == POWER_IDLE ? POWER_IDLE_POLL_MS : 1;
+
+    sched_cancel(input_timer);
+    input_timer = sched_every_ms(input_ms, input_task, NULL);
+    sched_cancel(display_timer);
+    display_timer = sched_every_ms(display_ms, display_task, NULL);
+}
+
+// Borda de botão, chamada na IRQ: ocioso, a leitura é antecipada em vez de
+// esperar o próximo período
+void button_notify() {
+    if (power_get_state() != POWER_ACTIVE)
+        sched_post(input_task, NULL);
+}
+
+// Inicia a leitura periódica das entradas e o controle de energia
+void start_input_task(void *arg) {
+    static const uint wake_pins[] = {BUTTON_A, BUTTON_B};
+
+    input_timer = sched_every_ms(INPUT_PERIOD_MS, input_task, NULL);
+    power_init(wake_pins, count_of(wake_pins), power_changed);
+    buttons_set_notify(button_notify);
+}
+
+// Etapas que o boot rápido adia para depois das entradas e do display. Rodam
+// na primeira passada do escalonador, na ordem em que foram postadas; os
+// toques que chegarem antes ficam na fila dos botões.
+void boot_storage_task(void *arg) {
+    attendance_init();  // Localiza o fim do registro de presença na flash
+    boot_mark(BOOT_STORAGE);
+}
+
+void boot_audio_task(void *arg) {
+    setup_audio();  // Configura os buzzers e toca o alerta de início
+    boot_mark(BOOT_AUDIO);
+}
+
+void boot_usb_task(void *arg) {
+    stdio_init_all();  // Inicializa o sistema de entrada e saída (USB)
+    boot_mark(BOOT_USB);
+}
+
+// Configura o display SSD1306 e mostra a tela inicial
+void setup_display() {
     i2c_init(i2c1, SSD1306_I2C_CLK * 1000);
     gpio_set_function(I2C_SDA_PIN, GPIO_FUNC_I2C);
     gpio_set_function(I2C_SCL_PIN, GPIO_FUNC_I2C);
@@ -263,40 +382,63 @@ int main() {
     gpio_pull_up(I2C_SCL_PIN);
 
     SSD1306_init();  // Inicializa o display corretamente ao ligar
+#if SSD1306_I2C_CLK_AUTO
+    SSD1306_negotiate_clock();  // Sobe o clock do I2C até a maior velocidade que o display aceita
+#endif
+    SSD1306_dma_init();  // Reserva um canal DMA para envios assíncronos ao display
 
-    struct render_area frame_area = {0, SSD1306_WIDTH - 1, 0, SSD1306_NUM_PAGES - 1};
+    static struct render_area frame_area = {
+        .start_col = 0, .end_col = SSD1306_WIDTH - 1, .start_page = 0, .end_page = SSD1306_NUM_PAGES - 1};
     calc_render_area_buflen(&frame_area);
 
-    uint8_t buf[SSD1306_BUF_LEN];
-    memset(buf, 0, SSD1306_BUF_LEN);
-    render(buf, &frame_area);
+    // Buffer estático com espaço reservado para o byte de controle do I2C
+    static uint8_t frame[SSD1306_FRAME_LEN];
+    uint8_t *buf = frame + SSD1306_BUF_PREFIX;
 
-    const char *startup_text[] = {
-        "   APERTE O    ",
-        "  BOTÃO A PARA ",
-        "  CONFIRMAR A  ",
-        "    PRESENÇA   "
-    };
+    // A partir daqui o buffer pertence à camada de exibição (núcleo 1 no modo multicore)
+    display_init(buf, &frame_area);
 
     // Exibe a mensagem inicial na tela
-    draw_text_display(startup_text, buf, &frame_area);
-
-    // Aguarda 5 segundos antes de iniciar o sistema
-    sleep_ms(5000);
-
-    // Começa a interação com os botões e joystick
-    while (true) {
-        if (read_joystick()) {
-            gpio_put(LEDvr, 1); // Acende LED 12 (LEDvr) quando o joystick é movido
-            while (!gpio_get(BUTTON_A)) {
-                sleep_ms(100);  // Aguarda o botão A ser pressionado
-            }
-            gpio_put(LEDvr, 0);  // Desliga LED 12 após pressionar o botão A
-            read_buttons(buf, &frame_area);  // Continua a leitura dos botões
-        } else {
-            read_buttons(buf, &frame_area);  // Caso o joystick não seja movido, só interage com os botões
-        }
-    }
+    display_screen(screen_startup);
+}
+
+// Função principal
+int main() {
+    boot_mark(BOOT_MAIN);
+
+    setup_inputs();  // Botões por interrupção desde já: nenhum toque se perde
+    boot_mark(BOOT_INPUT);
+
+    setup_display();
+    boot_mark(BOOT_DISPLAY);
+
+    // Máquinas de estado do fluxo de presença e do joystick
+    kiosk.observer = joystick.observer = log_transition;
+    fsm_start(&kiosk, &kiosk_def, time_us_32());
+    fsm_start(&joystick, &joystick_def, time_us_32());
+
+    display_timer = sched_every_ms(1, display_task, NULL);
+    trace_set_report(print_reports);  // Boot, energia e latências no 's', mesmo sem os pontos de trace
+    trace_set_input(console_input);  // Exportação do registro de presença
+    sched_every_ms(TRACE_POLL_MS, trace_task, NULL);  // Comandos pela USB: trace e exportação
+
+#if BOOT_FAST
+    // O registro vem primeiro: precisa estar pronto antes da primeira presença
+    sched_post(boot_storage_task, NULL);
+    sched_post(boot_audio_task, NULL);
+    sched_post(boot_usb_task, NULL);
+    start_input_task(NULL);  // Botões e joystick já na primeira passada
+#else
+    boot_usb_task(NULL);
+    boot_storage_task(NULL);
+    boot_audio_task(NULL);
+
+    // Começa a interação com os botões e joystick após 5 segundos
+    sched_after_ms(BOOT_INPUT_DELAY_MS, start_input_task, NULL);
+#endif
+
+    // Executa as tarefas; entre eventos o processador dorme
+    sched_run();
 
     return 0;
 }
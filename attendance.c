@@ -0,0 +1,208 @@
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/flash.h"
+#include "hardware/flash.h"
+#include "attendance.h"
+
+#define ATTENDANCE_OFFSET (PICO_FLASH_SIZE_BYTES - ATTENDANCE_SECTORS * FLASH_SECTOR_SIZE)
+#define RECORDS_PER_PAGE (FLASH_PAGE_SIZE / sizeof(attendance_record))
+#define RECORDS_PER_SECTOR (FLASH_SECTOR_SIZE / sizeof(attendance_record))
+#define TOTAL_SLOTS (ATTENDANCE_SECTORS * RECORDS_PER_SECTOR)
+
+// Tempo máximo para o outro núcleo liberar a flash
+#define FLASH_LOCKOUT_TIMEOUT_MS 100
+
+static_assert(sizeof(attendance_record) == 16, "registro deve ter 16 bytes");
+
+static uint32_t head_slot;   // Próxima posição livre do anel
+static uint32_t next_seq;
+static uint32_t boot;
+static uint16_t session;
+
+// Cópia em RAM da página que contém head_slot
+static uint8_t page_buf[FLASH_PAGE_SIZE];
+static uint32_t page_slot;   // Primeira posição da página em page_buf
+static bool page_dirty = false;
+static bool erase_pending = false;  // O setor de page_slot ainda tem dados antigos
+
+static const attendance_record *slot_ptr(uint32_t slot) {
+    return (const attendance_record *)(XIP_BASE + ATTENDANCE_OFFSET + slot * sizeof(attendance_record));
+}
+
+static uint8_t crc8(const uint8_t *data, uint len) {
+    uint8_t crc = 0;
+    while (len--) {
+        crc ^= *data++;
+        for (int i = 0; i < 8; i++)
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+    return crc;
+}
+
+static bool record_valid(const attendance_record *r) {
+    return r->seq != 0xFFFFFFFF && r->crc == crc8((const uint8_t *)r, sizeof(*r) - 1);
+}
+
+static bool range_erased(uint32_t slot, uint32_t count) {
+    const uint32_t *p = (const uint32_t *)slot_ptr(slot);
+    for (uint32_t i = 0; i < count * sizeof(attendance_record) / 4; i++) {
+        if (p[i] != 0xFFFFFFFF)
+            return false;
+    }
+    return true;
+}
+
+// Prepara page_buf para a página de head_slot
+static void load_page(void) {
+    page_slot = head_slot - head_slot % RECORDS_PER_PAGE;
+    if (head_slot % RECORDS_PER_SECTOR == 0)
+        erase_pending = !range_erased(head_slot, RECORDS_PER_SECTOR);
+
+    if (erase_pending)
+        memset(page_buf, 0xFF, sizeof(page_buf));
+    else
+        memcpy(page_buf, slot_ptr(page_slot), sizeof(page_buf));
+}
+
+// Procura o registro mais recente e continua o anel logo depois dele
+void attendance_init(void) {
+    int32_t last = -1;
+    uint32_t last_seq = 0;
+
+    for (uint32_t slot = 0; slot < TOTAL_SLOTS; slot++) {
+        const attendance_record *r = slot_ptr(slot);
+        if (record_valid(r) && r->seq > last_seq) {
+            last_seq = r->seq;
+            last = slot;
+        }
+    }
+
+    if (last < 0) {
+        head_slot = 0;
+        next_seq = 1;
+        boot = 0;
+        session = 0;
+    } else {
+        const attendance_record *r = slot_ptr(last);
+        head_slot = (last + 1) % TOTAL_SLOTS;
+        next_seq = r->seq + 1;
+        boot = r->boot + 1;
+        session = r->session + (r->type == ATTENDANCE_RESET ? 1 : 0);
+
+        // Pula posições escritas pela metade numa queda de energia
+        while (head_slot % RECORDS_PER_SECTOR != 0 && !range_erased(head_slot, 1))
+            head_slot = (head_slot + 1) % TOTAL_SLOTS;
+    }
+
+    erase_pending = false;
+    page_dirty = false;  // Montar de novo descarta o que só estava em RAM
+    load_page();
+}
+
+// Executado com a flash liberada: interrupções desligadas e o outro núcleo parado
+static void program_page(void *param) {
+    uint32_t page_offset = ATTENDANCE_OFFSET + page_slot * sizeof(attendance_record);
+
+    if (erase_pending) {
+        flash_range_erase(page_offset - page_offset % FLASH_SECTOR_SIZE, FLASH_SECTOR_SIZE);
+        erase_pending = false;
+    }
+    // Regravar a página só altera bits 1 -> 0, os registros já gravados se mantêm
+    flash_range_program(page_offset, page_buf, FLASH_PAGE_SIZE);
+}
+
+// Grava na flash os registros ainda só em RAM
+void attendance_sync(void) {
+    if (!page_dirty)
+        return;
+    if (flash_safe_execute(program_page, NULL, FLASH_LOCKOUT_TIMEOUT_MS) == PICO_OK)
+        page_dirty = false;
+}
+
+// Página cheia: grava e passa para a próxima, apagando o setor se for o caso.
+// Retorna false se a flash não pôde ser liberada; a página segue em RAM.
+static bool advance_if_full(void) {
+    if (head_slot - page_slot < RECORDS_PER_PAGE)
+        return true;
+
+    attendance_sync();
+    if (page_dirty)
+        return false;
+    head_slot %= TOTAL_SLOTS;
+    load_page();
+    return true;
+}
+
+// Acrescenta um registro. Ele fica em RAM até a página encher ou até attendance_sync().
+bool attendance_append(uint8_t type) {
+    if (!advance_if_full())
+        return false;
+
+    attendance_record rec = {
+        .seq = next_seq,
+        .boot = boot,
+        .timestamp_ms = to_ms_since_boot(get_absolute_time()),
+        .session = session,
+        .type = type,
+    };
+    rec.crc = crc8((const uint8_t *)&rec, sizeof(rec) - 1);
+
+    memcpy(page_buf + (head_slot - page_slot) * sizeof(rec), &rec, sizeof(rec));
+    page_dirty = true;
+    next_seq++;
+    if (type == ATTENDANCE_RESET)
+        session++;
+
+    head_slot++;
+    advance_if_full();  // Se falhar agora, tenta de novo no próximo registro
+    return true;
+}
+
+uint16_t attendance_session(void) {
+    return session;
+}
+
+uint32_t attendance_next_seq(void) {
+    return next_seq;
+}
+
+// Começa a leitura no registro de seq from_seq (ou no primeiro depois dele que
+// ainda estiver no anel). Grava antes os registros pendentes em RAM, para que
+// todos os anteriores ao início estejam na flash.
+void attendance_iter_begin(attendance_iter *it, uint32_t from_seq) {
+    uint32_t end_seq = next_seq;
+
+    attendance_sync();
+    if (page_dirty) {
+        // A flash não pôde ser liberada: a página em RAM fica para a próxima
+        // leitura, que começa no seu primeiro registro
+        for (uint i = 0; i < head_slot - page_slot; i++) {
+            const attendance_record *r = (const attendance_record *)page_buf + i;
+            if (record_valid(r) && r->seq < end_seq)
+                end_seq = r->seq;
+        }
+    }
+
+    // Logo depois da posição livre está o setor mais antigo do anel
+    *it = (attendance_iter){
+        .slot = head_slot % TOTAL_SLOTS,
+        .left = TOTAL_SLOTS,
+        .from_seq = from_seq,
+        .end_seq = end_seq,
+    };
+}
+
+// Próximo registro gravado, ou NULL no fim. O ponteiro é para a flash: o
+// conteúdo só muda se o setor for apagado quando o anel voltar a ele. Só as
+// posições vazias são puladas; o CRC-8 fica para quem lê, que é onde o custo
+// por registro deixa de limitar a vazão.
+const attendance_record *attendance_iter_next(attendance_iter *it) {
+    while (it->left) {
+        const attendance_record *r = slot_ptr(it->slot);
+        it->slot = (it->slot + 1) % TOTAL_SLOTS;
+        it->left--;
+        if (r->seq != 0xFFFFFFFF && r->seq >= it->from_seq && r->seq < it->end_seq)
+            return r;
+    }
+    return NULL;
+}
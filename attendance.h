@@ -0,0 +1,46 @@
+#ifndef ATTENDANCE_H_
+#define ATTENDANCE_H_
+
+#include "pico/stdlib.h"
+
+// Registro de presença em flash: log somente de acréscimo nos últimos setores
+// da flash, usado como anel. Os registros ficam num buffer de página em RAM e
+// são gravados em lote; cada setor só é apagado quando o anel volta a ele, o
+// que distribui o desgaste igualmente entre todos. Cada registro tem CRC, e
+// um registro interrompido por queda de energia é ignorado na montagem.
+
+#define ATTENDANCE_SECTORS 32  // 32 x 4 KB = 8192 registros
+
+typedef enum {
+    ATTENDANCE_PRESENCE = 1,  // Presença confirmada (botão A)
+    ATTENDANCE_RESET = 2      // Dados reiniciados (botão B), encerra a sessão
+} attendance_event;
+
+// Registro de tamanho fixo: 16 por página de flash
+typedef struct {
+    uint32_t seq;           // Sequência global, nunca se repete
+    uint32_t boot;          // Contador de boots, para ordenar os timestamps
+    uint32_t timestamp_ms;  // Milissegundos desde o boot
+    uint16_t session;       // Sessão de atendimento
+    uint8_t type;           // attendance_event
+    uint8_t crc;            // CRC-8 dos 15 bytes anteriores
+} attendance_record;
+
+// Leitura dos registros gravados, do mais antigo ao mais recente, direto da
+// flash (XIP), sem cópia
+typedef struct {
+    uint32_t slot;      // Próxima posição do anel a examinar
+    uint32_t left;      // Posições ainda não examinadas
+    uint32_t from_seq;  // Primeiro seq entregue
+    uint32_t end_seq;   // Registros a partir deste, gravados depois do início, ficam de fora
+} attendance_iter;
+
+extern void attendance_init(void);
+extern bool attendance_append(uint8_t type);
+extern void attendance_sync(void);
+extern uint16_t attendance_session(void);
+extern uint32_t attendance_next_seq(void);
+extern void attendance_iter_begin(attendance_iter *it, uint32_t from_seq);
+extern const attendance_record *attendance_iter_next(attendance_iter *it);
+
+#endif /* ATTENDANCE_H_ */
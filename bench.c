@@ -0,0 +1,252 @@
+// Microbenchmarks das primitivas de desenho e do envio ao display.
+//
+// Roda no dispositivo (tempo medido com time_us_64, resultado pela USB) e no
+// simulador do host (sim/), onde o barramento I2C simulado também conta bytes e
+// transações por quadro. A saída é CSV; com BENCH_JSON=1 (ou --json no host) é
+// JSON, para comparar versões do firmware.
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "ssd1306.h"
+
+#if PICO_ON_DEVICE
+#include "pico/stdio_usb.h"
+#else
+#include <time.h>
+#include "sim.h"
+#endif
+
+#ifndef BENCH_JSON
+#define BENCH_JSON 0
+#endif
+
+#define BENCH_MAX_RESULTS 16
+
+const uint I2C_SDA_PIN = 14;
+const uint I2C_SCL_PIN = 15;
+
+typedef struct {
+    const char *scene;
+    const char *op;
+    uint32_t iterations;
+    double ns_per_op;
+    int64_t bus_bytes;       // Por quadro; -1 quando o barramento não é medido
+    int64_t transactions;    // Por quadro; -1 quando o barramento não é medido
+} bench_result;
+
+static bench_result results[BENCH_MAX_RESULTS];
+static uint result_count = 0;
+
+static struct render_area frame_area = {
+    .start_col = 0, .end_col = SSD1306_WIDTH - 1, .start_page = 0, .end_page = SSD1306_NUM_PAGES - 1};
+static uint8_t frame[SSD1306_FRAME_LEN];
+static uint8_t *buf = frame + SSD1306_BUF_PREFIX;
+
+// As telas de quatro linhas exibidas pelo BitDogLab.c
+static const char *const screens[][4] = {
+    {"   APERTE O    ", "  BOTÃO A PARA ", "  CONFIRMAR A  ", "    PRESENÇA   "},
+    {"   PRESENCA    ", "  CONFIRMADA   ", "    PRESS B    ", "   (COLETE)    "},
+    {"   PRONTO      ", "  DADOS SENDO  ", "  REINICIADOS  ", "    AGUARDE    "},
+    {"  OBRIGADO ATÉ  ", "  O PROXIMO     ", "   HORARIO      ", "               "},
+};
+#define NUM_SCREENS (sizeof(screens) / sizeof(screens[0]))
+
+static uint64_t now_ns(void) {
+#if PICO_ON_DEVICE
+    return time_us_64() * 1000;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+#endif
+}
+
+// Bytes e transações no barramento desde o último bus_reset()
+static void bus_reset(void) {
+#if !PICO_ON_DEVICE
+    sim_i2c_reset_stats();
+#endif
+}
+
+static bool bus_read(uint64_t *bytes, uint64_t *transactions) {
+#if PICO_ON_DEVICE
+    return false;
+#else
+    sim_i2c_stats s;
+    sim_i2c_get_stats(&s);
+    *bytes = s.bytes;
+    *transactions = s.transactions;
+    return true;
+#endif
+}
+
+static void draw_screen(uint n) {
+    for (uint line = 0; line < 4; line++)
+        WriteString(buf, 5, line * 8, (char *)screens[n % NUM_SCREENS][line]);
+}
+
+// Executa fn `iterations` vezes e registra o tempo médio. Para operações que
+// enviam um quadro por iteração (per_frame), registra também o tráfego médio.
+static void run(const char *scene, const char *op, uint32_t iterations, bool per_frame, void (*fn)(uint32_t i)) {
+    if (result_count == BENCH_MAX_RESULTS)
+        return;
+
+    bus_reset();
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < iterations; i++)
+        fn(i);
+    SSD1306_flush_wait();
+    uint64_t elapsed = now_ns() - start;
+
+    bench_result *r = &results[result_count++];
+    uint64_t bytes, transactions;
+    r->scene = scene;
+    r->op = op;
+    r->iterations = iterations;
+    r->ns_per_op = (double)elapsed / iterations;
+    r->bus_bytes = -1;
+    r->transactions = -1;
+    if (per_frame && bus_read(&bytes, &transactions)) {
+        r->bus_bytes = bytes / iterations;
+        r->transactions = transactions / iterations;
+    }
+}
+
+static void op_set_pixel(uint32_t i) {
+    int x = i % SSD1306_WIDTH, y = (i / SSD1306_WIDTH) % SSD1306_HEIGHT;
+    SetPixel(buf, x, y, ((x + y + i / SSD1306_BUF_LEN) & 1) != 0);  // Xadrez que se inverte a cada tela
+}
+
+static void op_draw_line(uint32_t i) {
+    if (i & 1)
+        DrawLine(buf, 0, SSD1306_HEIGHT - 1, SSD1306_WIDTH - 1, 0, (i & 2) != 0);
+    else
+        DrawLine(buf, 0, 0, SSD1306_WIDTH - 1, SSD1306_HEIGHT - 1, (i & 2) != 0);
+}
+
+static void op_write_char(uint32_t i) {
+    WriteChar(buf, (i % 16) * 8, ((i / 16) % SSD1306_NUM_PAGES) * 8, 'A' + i % 26);
+}
+
+// Preenche a tela inteira pixel a pixel, como referência para FillRect
+static void op_fill_pixels(uint32_t i) {
+    for (int y = 0; y < SSD1306_HEIGHT; y++)
+        for (int x = 0; x < SSD1306_WIDTH; x++)
+            SetPixel(buf, x, y, i & 1);
+}
+
+static void op_fill_rect(uint32_t i) {
+    FillRect(buf, 0, 0, SSD1306_WIDTH, SSD1306_HEIGHT, i & 1);
+}
+
+static void op_invert_rect(uint32_t i) {
+    InvertRect(buf, 3, 5, SSD1306_WIDTH - 6, SSD1306_HEIGHT - 10);
+}
+
+static void op_write_char_unaligned(uint32_t i) {
+    WriteChar(buf, (i % 16) * 8, 3 + (i / 16) % 3 * 8, 'A' + i % 26);
+}
+
+static void op_write_screen(uint32_t i) {
+    draw_screen(i);
+}
+
+static void op_write_screen_prop(uint32_t i) {
+    for (uint line = 0; line < 4; line++)
+        WriteStringFont(buf, &ssd1306_font_8x8_prop, 5, line * 8, screens[i % NUM_SCREENS][line]);
+}
+
+static void op_render(uint32_t i) {
+    render(buf, &frame_area);
+}
+
+static void op_render_async(uint32_t i) {
+    render_async(buf, &frame_area, NULL);
+    SSD1306_flush_wait();
+}
+
+// Troca de tela como no aplicativo: compõe o texto e envia só o que mudou
+static void op_screen_change(uint32_t i) {
+    draw_screen(i);
+    render_dirty(buf);
+}
+
+static void print_results(bool json) {
+    const char *platform = PICO_ON_DEVICE ? "device" : "host";
+
+    if (!json)
+        printf("platform,scene,op,iterations,ns_per_op,bus_bytes_per_frame,transactions_per_frame\n");
+    else
+        printf("[\n");
+
+    for (uint i = 0; i < result_count; i++) {
+        const bench_result *r = &results[i];
+        char bytes[24] = "", transactions[24] = "";
+
+        if (r->bus_bytes >= 0) {
+            snprintf(bytes, sizeof(bytes), "%lld", (long long)r->bus_bytes);
+            snprintf(transactions, sizeof(transactions), "%lld", (long long)r->transactions);
+        } else if (json) {
+            strcpy(bytes, "null");
+            strcpy(transactions, "null");
+        }
+
+        if (!json)
+            printf("%s,%s,%s,%lu,%.1f,%s,%s\n", platform, r->scene, r->op, (unsigned long)r->iterations,
+                   r->ns_per_op, bytes, transactions);
+        else
+            printf("  {\"platform\": \"%s\", \"scene\": \"%s\", \"op\": \"%s\", \"iterations\": %lu, "
+                   "\"ns_per_op\": %.1f, \"bus_bytes_per_frame\": %s, \"transactions_per_frame\": %s}%s\n",
+                   platform, r->scene, r->op, (unsigned long)r->iterations, r->ns_per_op, bytes, transactions,
+                   i + 1 < result_count ? "," : "");
+    }
+
+    if (json)
+        printf("]\n");
+}
+
+int main(int argc, char **argv) {
+    bool json = BENCH_JSON;
+
+    stdio_init_all();
+#if PICO_ON_DEVICE
+    while (!stdio_usb_connected())
+        sleep_ms(100);  // Espera o terminal abrir para não perder a saída
+#else
+    sim_set_trace(false);  // Só o resultado vai para a saída padrão
+    for (int i = 1; i < argc; i++)
+        json |= !strcmp(argv[i], "--json");
+#endif
+
+    i2c_init(i2c1, SSD1306_I2C_CLK * 1000);
+    gpio_set_function(I2C_SDA_PIN, GPIO_FUNC_I2C);
+    gpio_set_function(I2C_SCL_PIN, GPIO_FUNC_I2C);
+    gpio_pull_up(I2C_SDA_PIN);
+    gpio_pull_up(I2C_SCL_PIN);
+
+    SSD1306_init();
+    SSD1306_dma_init();
+    calc_render_area_buflen(&frame_area);
+
+    run("checker", "SetPixel", SSD1306_BUF_LEN * 8 * 8, false, op_set_pixel);
+    run("diagonals", "DrawLine", 2000, false, op_draw_line);
+    run("glyphs", "WriteChar", 4096, false, op_write_char);
+    run("glyphs_y3", "WriteChar", 4096, false, op_write_char_unaligned);
+    run("full_screen", "SetPixel", 200, false, op_fill_pixels);
+    run("full_screen", "FillRect", 200, false, op_fill_rect);
+    run("inset", "InvertRect", 200, false, op_invert_rect);
+    run("screens", "WriteString", 1000, false, op_write_screen);
+    run("screens", "WriteStringFont_prop", 1000, false, op_write_screen_prop);
+    run("full_frame", "render", 50, true, op_render);
+    run("full_frame", "render_async", 50, true, op_render_async);
+    run("screens", "render_dirty", 50, true, op_screen_change);
+
+    print_results(json);
+
+#if PICO_ON_DEVICE
+    while (true)
+        sleep_ms(1000);
+#endif
+    return 0;
+}
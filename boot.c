@@ -0,0 +1,39 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "boot.h"
+
+static const char *const stage_names[BOOT_NUM_STAGES] = {
+#define BOOT_NAME(id, name) name,
+    BOOT_STAGES(BOOT_NAME)
+#undef BOOT_NAME
+};
+
+static uint32_t stage_us[BOOT_NUM_STAGES];
+static bool stage_done[BOOT_NUM_STAGES];
+
+// Marca o fim de uma etapa; só a primeira marca de cada uma vale, então pode
+// ser chamada de dentro de uma tarefa periódica
+void boot_mark(boot_stage stage) {
+    if (stage >= BOOT_NUM_STAGES || stage_done[stage])
+        return;
+    stage_us[stage] = time_us_32();
+    stage_done[stage] = true;
+}
+
+// Instante da etapa, ou 0 se ainda não terminou
+uint32_t boot_stage_us(boot_stage stage) {
+    return stage < BOOT_NUM_STAGES && stage_done[stage] ? stage_us[stage] : 0;
+}
+
+// Uma linha por etapa, na ordem de BOOT_STAGES, e a configuração usada:
+//   B <etapa> at_us=<t>     (at_us=- se ainda não terminou)
+//   B fast=<0|1>
+void boot_print_report(void) {
+    for (uint i = 0; i < BOOT_NUM_STAGES; i++) {
+        if (stage_done[i])
+            printf("B %s at_us=%lu\n", stage_names[i], (unsigned long)stage_us[i]);
+        else
+            printf("B %s at_us=-\n", stage_names[i]);
+    }
+    printf("B fast=%d\n", BOOT_FAST);
+}
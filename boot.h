@@ -0,0 +1,42 @@
+#ifndef BOOT_H_
+#define BOOT_H_
+
+#include "pico/stdlib.h"
+
+// Boot rápido. Com BOOT_FAST, main sobe só as entradas e o display e já começa
+// a ler os botões; o registro de presença, o áudio e a USB ficam para a
+// primeira passada do escalonador. Sem ela, tudo é iniciado antes e os botões
+// só valem depois de BOOT_INPUT_DELAY_MS, como no fluxo original.
+//
+// Cada etapa guarda o instante em que terminou, em microssegundos desde que o
+// runtime do SDK iniciou o timer (logo depois do reset), para leitura posterior
+// pelo comando 's' (linhas B).
+
+#ifndef BOOT_FAST
+#define BOOT_FAST 1
+#endif
+
+#define BOOT_INPUT_DELAY_MS 5000  // Sem BOOT_FAST: espera até a primeira leitura
+
+// Etapas: identificador e nome usado na saída
+#define BOOT_STAGES(X)        \
+    X(MAIN, "main")           \
+    X(INPUT, "input")         \
+    X(DISPLAY, "display")     \
+    X(READY, "ready")         \
+    X(STORAGE, "storage")     \
+    X(AUDIO, "audio")         \
+    X(USB, "usb")
+
+typedef enum {
+#define BOOT_ENUM(id, name) BOOT_##id,
+    BOOT_STAGES(BOOT_ENUM)
+#undef BOOT_ENUM
+    BOOT_NUM_STAGES
+} boot_stage;
+
+extern void boot_mark(boot_stage stage);
+extern uint32_t boot_stage_us(boot_stage stage);
+extern void boot_print_report(void);
+
+#endif /* BOOT_H_ */
@@ -0,0 +1,226 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/sync.h"
+#include "buttons.h"
+
+// Estado de cada botão do lado da IRQ (debounce) e do consumidor (gestos)
+typedef struct {
+    uint pin;
+    uint32_t last_edge_us;     // Última borda aceita
+    alarm_id_t settle_alarm;   // Releitura no fim da janela de debounce, 0 se nenhuma
+    volatile bool pressed;     // Estado após o debounce
+    bool held;                 // Visto como pressionado pelo consumidor
+    bool long_sent;            // Pressionamento longo já reportado
+    bool released_once;        // last_release_us é válido
+    bool resync;               // Mudança perdida por fila cheia: reler o pino quando houver espaço
+    uint32_t resync_us;        // Borda da mudança perdida
+    uint32_t press_us;
+    uint32_t last_release_us;
+} button_state;
+
+static button_state buttons[BUTTONS_MAX];
+static uint num_buttons = 0;
+
+// Fila circular de eventos crus (só PRESS/RELEASE). Só a IRQ escreve queue_tail
+// e só o consumidor escreve queue_head.
+static button_event queue[BUTTON_QUEUE_LEN];
+static volatile uint32_t queue_head = 0;
+static volatile uint32_t queue_tail = 0;
+static volatile uint32_t dropped = 0;  // Bordas que encontraram a fila cheia
+static volatile bool resync_pending = false;  // Algum botão com resync
+static void (*notify_fn)(void);        // Chamada na IRQ a cada evento publicado
+
+// Latência entre a borda (IRQ) e a retirada do evento pelo laço principal
+static uint32_t latency_last_us = 0;
+static uint32_t latency_max_us = 0;
+
+// Evento derivado aguardando entrega (duplo toque gerado junto com um PRESS)
+static button_event pending;
+static bool has_pending = false;
+
+static button_state *find_button(uint pin) {
+    for (uint i = 0; i < num_buttons; i++) {
+        if (buttons[i].pin == pin)
+            return &buttons[i];
+    }
+    return NULL;
+}
+
+// Lê o pino e publica o novo estado, se mudou. Chamada na IRQ do GPIO e na do
+// alarme de releitura, que não se interrompem (mesma prioridade), e pelo
+// consumidor com as interrupções desligadas. Com a fila cheia o estado não muda:
+// o debounce continua igual ao que o consumidor viu, e o pino é relido quando
+// ele liberar espaço.
+static void sample(button_state *b, uint32_t now) {
+    bool pressed = !gpio_get(b->pin);  // Pull-up: nível baixo = pressionado
+    if (pressed == b->pressed) {
+        b->resync = false;  // Voltou ao estado publicado: nada a entregar
+        return;  // Borda sem mudança de estado
+    }
+
+    if (queue_tail - queue_head >= BUTTON_QUEUE_LEN) {
+        dropped++;
+        b->resync = true;
+        b->resync_us = now;
+        resync_pending = true;
+        return;
+    }
+    b->resync = false;
+    b->last_edge_us = now;
+    b->pressed = pressed;
+    queue[queue_tail % BUTTON_QUEUE_LEN] = (button_event){now, b->pin, pressed ? BUTTON_PRESS : BUTTON_RELEASE};
+    __dmb();  // O evento precisa estar escrito antes de ser publicado
+    queue_tail++;
+    if (notify_fn)
+        notify_fn();
+}
+
+// Fim da janela de debounce com bordas ignoradas: o nível em que o pino
+// assentou vale, mesmo que a última borda tenha caído dentro da janela
+static int64_t settle_alarm(alarm_id_t id, void *user_data) {
+    button_state *b = user_data;
+
+    b->settle_alarm = 0;
+    sample(b, time_us_32());
+    return 0;
+}
+
+// Relê os botões que perderam uma mudança, agora que a fila tem espaço. O
+// evento leva o instante da borda perdida.
+static void resync(void) {
+    uint32_t irq = save_and_disable_interrupts();
+
+    resync_pending = false;
+    for (uint i = 0; i < num_buttons; i++)
+        if (buttons[i].resync)
+            sample(&buttons[i], buttons[i].resync_us);
+    restore_interrupts(irq);
+}
+
+static void button_irq(uint gpio, uint32_t events) {
+    button_state *b = find_button(gpio);
+    if (!b)
+        return;
+
+    uint32_t now = time_us_32();
+    uint32_t elapsed = now - b->last_edge_us;
+    if (elapsed < BUTTON_DEBOUNCE_US) {
+        // Trepidação: ignorada agora, mas o pino é relido quando a janela fechar
+        if (!b->settle_alarm) {
+            alarm_id_t id = add_alarm_in_us(BUTTON_DEBOUNCE_US - elapsed, settle_alarm, b, true);
+            b->settle_alarm = id > 0 ? id : 0;
+        }
+        return;
+    }
+    sample(b, now);
+}
+
+// Configura as interrupções de borda dos pinos (já configurados como entrada com pull-up)
+void buttons_init(const uint *pins, uint count) {
+    if (count > BUTTONS_MAX)
+        count = BUTTONS_MAX;
+
+    for (uint i = 0; i < count; i++) {
+        if (buttons[i].settle_alarm)
+            cancel_alarm(buttons[i].settle_alarm);
+        buttons[i] = (button_state){0};
+        buttons[i].pin = pins[i];
+        buttons[i].pressed = !gpio_get(pins[i]);
+        buttons[i].held = buttons[i].pressed;
+        buttons[i].long_sent = true;  // Não reporta longo para um botão já pressionado no boot
+    }
+    num_buttons = count;
+
+    for (uint i = 0; i < count; i++)
+        gpio_set_irq_enabled_with_callback(pins[i], GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE, true, &button_irq);
+}
+
+// Função chamada dentro da IRQ a cada novo evento, por exemplo para antecipar a
+// leitura da fila quando ela é feita com pouca frequência. Deve ser curta.
+void buttons_set_notify(void (*fn)(void)) {
+    notify_fn = fn;
+}
+
+// Retira o próximo evento. Retorna false se não houver nenhum.
+bool buttons_get_event(button_event *ev) {
+    if (has_pending) {
+        *ev = pending;
+        has_pending = false;
+        return true;
+    }
+
+    // Pressionamento longo: não há borda, então é verificado a cada leitura
+    uint32_t now = time_us_32();
+    for (uint i = 0; i < num_buttons; i++) {
+        button_state *b = &buttons[i];
+        if (b->held && !b->long_sent && now - b->press_us >= BUTTON_LONG_PRESS_US) {
+            b->long_sent = true;
+            *ev = (button_event){b->press_us + BUTTON_LONG_PRESS_US, b->pin, BUTTON_LONG_PRESS};
+            return true;
+        }
+    }
+
+    if (queue_head == queue_tail)
+        return false;
+    __dmb();
+    *ev = queue[queue_head % BUTTON_QUEUE_LEN];
+    queue_head++;
+    if (resync_pending)
+        resync();
+
+    latency_last_us = time_us_32() - ev->time_us;
+    if (latency_last_us > latency_max_us)
+        latency_max_us = latency_last_us;
+
+    button_state *b = find_button(ev->pin);
+    if (ev->type == BUTTON_PRESS) {
+        if (b->released_once && ev->time_us - b->last_release_us <= BUTTON_DOUBLE_PRESS_US) {
+            pending = (button_event){ev->time_us, ev->pin, BUTTON_DOUBLE_PRESS};
+            has_pending = true;
+            b->released_once = false;  // Um terceiro toque não forma outro duplo
+        }
+        b->held = true;
+        b->long_sent = false;
+        b->press_us = ev->time_us;
+    } else {
+        if (b->held)
+            b->released_once = true;
+        b->held = false;
+        b->last_release_us = ev->time_us;
+    }
+    return true;
+}
+
+// Estado do botão após o debounce
+bool buttons_is_pressed(uint pin) {
+    button_state *b = find_button(pin);
+    return b && b->pressed;
+}
+
+// Descarta os eventos pendentes, mantendo o estado dos botões coerente
+void buttons_flush(void) {
+    button_event ev;
+    while (buttons_get_event(&ev))
+        ;
+}
+
+uint32_t buttons_dropped(void) {
+    return dropped;
+}
+
+// Latência da última retirada e a maior desde o boot, em us
+void buttons_latency(uint32_t *last_us, uint32_t *max_us) {
+    *last_us = latency_last_us;
+    *max_us = latency_max_us;
+}
+
+// Uma linha no relatório do comando 's':
+//   K latency_last_us=<t> latency_max_us=<t> dropped=<n>
+void buttons_print_report(void) {
+    uint32_t last_us, max_us;
+    buttons_latency(&last_us, &max_us);
+
+    printf("K latency_last_us=%lu latency_max_us=%lu dropped=%lu\n", (unsigned long)last_us,
+           (unsigned long)max_us, (unsigned long)buttons_dropped());
+}
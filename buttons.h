@@ -0,0 +1,41 @@
+#ifndef BUTTONS_H_
+#define BUTTONS_H_
+
+#include "pico/stdlib.h"
+
+// Botões por interrupção: as bordas dos pinos geram eventos com timestamp numa
+// fila circular (produtor = IRQ, consumidor = laço principal, sem travas).
+// O debounce é por tempo: bordas até BUTTON_DEBOUNCE_US depois da última aceita
+// são ignoradas, e ao fim dessa janela um alarme relê o pino, para que a borda
+// final de uma trepidação não se perca. Pressionamentos longos e duplos são
+// detectados na leitura da fila.
+
+#define BUTTONS_MAX 4              // Quantidade máxima de botões monitorados
+#define BUTTON_QUEUE_LEN 32        // Tamanho da fila de eventos (potência de 2)
+#define BUTTON_DEBOUNCE_US 20000   // Bordas dentro deste intervalo são trepidação
+#define BUTTON_LONG_PRESS_US 1000000   // Pressionado por mais que isso = longo
+#define BUTTON_DOUBLE_PRESS_US 400000  // Novo toque até este tempo após soltar = duplo
+
+typedef enum {
+    BUTTON_PRESS,
+    BUTTON_RELEASE,
+    BUTTON_LONG_PRESS,
+    BUTTON_DOUBLE_PRESS
+} button_event_type;
+
+typedef struct {
+    uint32_t time_us;  // Instante da borda (time_us_32)
+    uint8_t pin;
+    uint8_t type;      // button_event_type
+} button_event;
+
+extern void buttons_init(const uint *pins, uint count);
+extern void buttons_set_notify(void (*fn)(void));
+extern bool buttons_get_event(button_event *ev);
+extern bool buttons_is_pressed(uint pin);
+extern void buttons_flush(void);
+extern uint32_t buttons_dropped(void);
+extern void buttons_latency(uint32_t *last_us, uint32_t *max_us);
+extern void buttons_print_report(void);
+
+#endif /* BUTTONS_H_ */
@@ -0,0 +1,405 @@
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "pico/flash.h"
+#include "pico/util/queue.h"
+#include "display.h"
+
+typedef enum {
+    DISPLAY_CMD_RESET,
+    DISPLAY_CMD_CLEAR,
+    DISPLAY_CMD_TEXT,
+    DISPLAY_CMD_SCREEN,
+    DISPLAY_CMD_MARQUEE,
+    DISPLAY_CMD_SCROLL,
+    DISPLAY_CMD_POWER,
+    DISPLAY_CMD_CLOCK
+} display_cmd_type;
+
+typedef struct {
+    uint8_t type;                        // display_cmd_type
+    uint8_t line;                        // DISPLAY_CMD_MARQUEE: linha; DISPLAY_CMD_SCROLL: nº de linhas;
+                                         // DISPLAY_CMD_POWER: aceso ou apagado
+    uint32_t post_us;                    // Instante em que o comando foi postado
+    const char *text[DISPLAY_LINES];     // DISPLAY_CMD_TEXT; text[0] para DISPLAY_CMD_MARQUEE
+    const char *const *lines;            // Só para DISPLAY_CMD_SCROLL
+    const uint8_t *frame;                // Só para DISPLAY_CMD_SCREEN
+    uint32_t khz;                        // Só para DISPLAY_CMD_CLOCK
+} display_cmd;
+
+// Rolagem em andamento. Nos modos por hardware o controlador faz o trabalho:
+// a horizontal roda a página sozinha e a vertical só troca a linha inicial,
+// sem reenviar a tela. Os modos por software redesenham a cada passo.
+typedef enum {
+    SCROLL_NONE,
+    SCROLL_HW_MARQUEE,   // Texto cabe na largura: rotação contínua da página
+    SCROLL_SW_MARQUEE,   // Texto mais largo que a tela
+    SCROLL_HW_LINES,     // Até SSD1306_RAM_PAGES linhas: desloca a linha inicial
+    SCROLL_SW_LINES      // Mais linhas do que cabem na RAM do controlador
+} scroll_mode;
+
+static struct {
+    scroll_mode mode;
+    const char *text;
+    const char *const *lines;
+    uint count;          // Linhas do modo vertical
+    uint line;           // Linha do letreiro
+    int period;          // Pixels até o conteúdo se repetir
+    int pos;
+    uint32_t next_us;
+    uint32_t step_us;
+} scroll;
+
+static uint8_t *disp_buf;
+static struct render_area *disp_area;
+
+// Tela pronta (screens.h) que está no painel, enviada direto da flash. Enquanto
+// não for NULL, disp_buf está desatualizado: só é recarregado dela quando um
+// comando volta a desenhar no buffer, então telas prontas seguidas não custam
+// composição nem cópia na RAM.
+static const uint8_t *shown_frame;
+
+// Páginas 4 a 7 da RAM do controlador, fora da tela até a rolagem vertical
+static uint8_t low_frame[SSD1306_FRAME_LEN];
+static uint8_t *low_buf = low_frame + SSD1306_BUF_PREFIX;
+static struct render_area low_area = {
+    .start_col = 0, .end_col = SSD1306_WIDTH - 1, .start_page = SSD1306_NUM_PAGES, .end_page = SSD1306_RAM_PAGES - 1};
+
+static queue_t display_queue;
+static bool core1_running = false;
+
+// As estatísticas são escritas só por quem executa os comandos; o contador de
+// descartes só por quem posta
+static volatile uint32_t stat_count, stat_last_us, stat_max_us;
+static volatile uint32_t stat_dropped;
+
+// Trocas de clock postadas (só pelo núcleo 0) e já executadas, para quem
+// precisa do clock novo antes de seguir
+static uint32_t clock_posted;
+static volatile uint32_t clock_done;
+
+// Interrompe a rolagem, devolve a tela à posição normal e apaga do buffer o que
+// rolava, para o próximo comando desenhar sobre uma área limpa
+static void scroll_stop(void) {
+    switch (scroll.mode) {
+        case SCROLL_HW_MARQUEE:
+            SSD1306_scroll_stop();  // O driver reenvia a página na próxima atualização
+            // fall through
+        case SCROLL_SW_MARQUEE:
+            FillRect(disp_buf, 0, scroll.line * 8, SSD1306_WIDTH, 8, false);
+            break;
+        case SCROLL_HW_LINES:
+            SSD1306_set_start_line(0);
+            // fall through
+        case SCROLL_SW_LINES:
+            FillRect(disp_buf, 0, 0, SSD1306_WIDTH, SSD1306_HEIGHT, false);
+            break;
+        default:
+            break;
+    }
+    scroll.mode = SCROLL_NONE;
+}
+
+static void scroll_step(void) {
+    switch (scroll.mode) {
+        case SCROLL_SW_MARQUEE: {
+            // Desenha o texto deslocado e uma segunda cópia logo atrás, para emendar
+            int y = scroll.line * 8;
+            FillRect(disp_buf, 0, y, SSD1306_WIDTH, 8, false);
+            WriteStringFont(disp_buf, &ssd1306_font_8x8, -scroll.pos, y, scroll.text);
+            WriteStringFont(disp_buf, &ssd1306_font_8x8, scroll.period - scroll.pos, y, scroll.text);
+            render_dirty(disp_buf);
+            break;
+        }
+        case SCROLL_HW_LINES:
+            SSD1306_set_start_line(scroll.pos);  // Um único comando por passo
+            break;
+        case SCROLL_SW_LINES:
+            FillRect(disp_buf, 0, 0, SSD1306_WIDTH, SSD1306_HEIGHT, false);
+            for (uint i = 0; i < scroll.count; i++) {
+                int y = i * 8 - scroll.pos;
+                if (y <= -8)
+                    y += scroll.period;  // Linhas que saíram por cima voltam por baixo
+                if (y < SSD1306_HEIGHT)
+                    WriteStringFont(disp_buf, &ssd1306_font_8x8, 5, y, scroll.lines[i]);
+            }
+            render_dirty(disp_buf);
+            break;
+        default:
+            return;
+    }
+    scroll.pos = (scroll.pos + 1) % scroll.period;
+    scroll.next_us += scroll.step_us;
+}
+
+static void start_marquee(const char *text, uint line) {
+    int y = line * 8;
+
+    scroll.text = text;
+    scroll.line = line;
+    scroll.pos = 0;
+    FillRect(disp_buf, 0, y, SSD1306_WIDTH, 8, false);
+
+    int width = StringWidth(&ssd1306_font_8x8, text);
+    if (width <= SSD1306_WIDTH) {
+        // Cabe na RAM da página: o controlador roda sozinho, sem tráfego no I2C
+        WriteStringFont(disp_buf, &ssd1306_font_8x8, 0, y, text);
+        render_dirty(disp_buf);
+        SSD1306_hscroll(line, line, true, DISPLAY_MARQUEE_HW_INTERVAL);
+        scroll.mode = SCROLL_HW_MARQUEE;
+    } else {
+        scroll.period = width + DISPLAY_MARQUEE_GAP;
+        scroll.step_us = DISPLAY_MARQUEE_STEP_MS * 1000;
+        scroll.next_us = time_us_32();
+        scroll.mode = SCROLL_SW_MARQUEE;
+    }
+}
+
+static void start_lines(const char *const *lines, uint count) {
+    scroll.lines = lines;
+    scroll.count = count;
+    scroll.pos = 0;
+    scroll.step_us = DISPLAY_SCROLL_STEP_MS * 1000;
+    scroll.next_us = time_us_32() + DISPLAY_SCROLL_PAUSE_MS * 1000;
+
+    if (count > SSD1306_RAM_PAGES) {
+        scroll.period = (count + 1) * 8;  // Uma linha em branco entre as voltas
+        scroll.mode = SCROLL_SW_LINES;
+        scroll_step();  // Desenha a primeira tela e espera a pausa
+        scroll.next_us = time_us_32() + DISPLAY_SCROLL_PAUSE_MS * 1000;
+        return;
+    }
+
+    // Todas as linhas cabem nas 8 páginas da RAM: as 4 primeiras na tela e o
+    // resto abaixo dela, de onde a linha inicial as traz
+    FillRect(disp_buf, 0, 0, SSD1306_WIDTH, SSD1306_HEIGHT, false);
+    for (uint i = 0; i < count && i < SSD1306_NUM_PAGES; i++)
+        WriteString(disp_buf, 5, i * 8, (char *)lines[i]);
+    render_dirty(disp_buf);
+
+    memset(low_buf, 0, SSD1306_BUF_LEN);
+    for (uint i = SSD1306_NUM_PAGES; i < count; i++)
+        WriteString(low_buf, 5, (i - SSD1306_NUM_PAGES) * 8, (char *)lines[i]);
+    render(low_buf, &low_area);
+    SSD1306_clear_dirty();  // As marcas vieram de low_buf, não da tela
+
+    scroll.period = SSD1306_RAM_LINES;
+    scroll.pos = 1;
+    scroll.mode = SCROLL_HW_LINES;
+}
+
+// Traz para disp_buf a tela pronta que está no painel, antes de desenhar sobre ela
+static void sync_buffer(void) {
+    if (!shown_frame)
+        return;
+    memcpy(disp_buf, shown_frame + SSD1306_BUF_PREFIX, SSD1306_BUF_LEN);
+    shown_frame = NULL;
+}
+
+// Executa o passo de rolagem vencido, se houver; devolve quando será o próximo
+static bool scroll_poll(uint32_t *next_us) {
+    if (scroll.mode == SCROLL_NONE || scroll.mode == SCROLL_HW_MARQUEE)
+        return false;
+    if ((int32_t)(time_us_32() - scroll.next_us) >= 0)
+        scroll_step();
+    *next_us = scroll.next_us;
+    return true;
+}
+
+static void execute(const display_cmd *cmd) {
+    scroll_stop();  // Qualquer comando novo encerra a rolagem anterior
+
+    switch (cmd->type) {
+        case DISPLAY_CMD_RESET:
+            SSD1306_init();  // Inicializa o display SSD1306 (a RAM do controlador é mantida)
+            break;
+        case DISPLAY_CMD_CLEAR:
+            shown_frame = NULL;  // O buffer inteiro é refeito, não precisa recarregar
+            memset(disp_buf, 0, SSD1306_BUF_LEN);  // Limpa o buffer
+            render_async(disp_buf, disp_area, NULL);  // Envia o buffer limpo via DMA
+            break;
+        case DISPLAY_CMD_TEXT: {
+            int y = 0;
+            sync_buffer();
+            for (uint i = 0; i < DISPLAY_LINES; i++) {
+                WriteString(disp_buf, 5, y, (char *)cmd->text[i]);  // Escreve o texto no buffer
+                y += 8;  // Incrementa o Y para o próximo texto
+            }
+            render_dirty(disp_buf);  // Envia apenas as regiões do buffer que mudaram
+            break;
+        }
+        case DISPLAY_CMD_SCREEN:
+            if (cmd->frame != shown_frame)
+                render_frame(cmd->frame);  // Quadro inteiro, lido da flash pelo I2C
+            shown_frame = cmd->frame;
+            break;
+        case DISPLAY_CMD_MARQUEE:
+            sync_buffer();
+            start_marquee(cmd->text[0], cmd->line);
+            break;
+        case DISPLAY_CMD_SCROLL:
+            sync_buffer();
+            start_lines(cmd->lines, cmd->line);
+            break;
+        case DISPLAY_CMD_POWER:
+            SSD1306_display_on(cmd->line);  // A RAM do controlador é mantida
+            break;
+        case DISPLAY_CMD_CLOCK:
+            // Quem executa os comandos é o único a usar o I2C: troca o clk_sys com
+            // o barramento parado e refaz os divisores do I2C para o novo clock
+            SSD1306_flush_wait();
+            set_sys_clock_khz(cmd->khz, false);
+            SSD1306_reclock();
+            clock_done++;
+            __sev();  // Acorda o núcleo 0, se espera a troca
+            break;
+    }
+
+    uint32_t latency = time_us_32() - cmd->post_us;
+    stat_last_us = latency;
+    if (latency > stat_max_us)
+        stat_max_us = latency;
+    stat_count++;
+}
+
+static bool post(display_cmd *cmd) {
+    cmd->post_us = time_us_32();
+    if (!core1_running)
+        execute(cmd);
+    else if (!queue_try_add(&display_queue, cmd)) {
+        stat_dropped++;  // Nunca bloqueia o núcleo 0
+        return false;
+    }
+    return true;
+}
+
+#if DISPLAY_MULTICORE
+// Laço do núcleo 1: executa comandos, acompanha o envio por DMA e dá os passos
+// de rolagem; sem nada pendente, dorme em WFE até o núcleo 0 postar outro
+// comando ou até o próximo passo
+static void core1_main(void) {
+    display_cmd cmd;
+
+    flash_safe_execute_core_init();  // Permite ao núcleo 0 pausar este núcleo para gravar a flash
+    while (true) {
+        uint32_t next_us;
+
+        if (queue_try_remove(&display_queue, &cmd))
+            execute(&cmd);
+        else if (!SSD1306_flush_poll())
+            continue;
+        else if (!scroll_poll(&next_us))
+            __wfe();
+        else if ((int32_t)(next_us - time_us_32()) > 0)
+            best_effort_wfe_or_timeout(delayed_by_us(get_absolute_time(), next_us - time_us_32()));
+    }
+}
+#endif
+
+// Recebe o buffer e a área do display, já inicializados, e inicia o núcleo 1
+void display_init(uint8_t *buf, struct render_area *frame_area) {
+    disp_buf = buf;
+    disp_area = frame_area;
+    calc_render_area_buflen(&low_area);
+
+#if DISPLAY_MULTICORE
+    queue_init(&display_queue, sizeof(display_cmd), DISPLAY_QUEUE_LEN);
+    multicore_launch_core1(core1_main);
+    core1_running = true;
+#endif
+}
+
+void display_reset(void) {
+    display_cmd cmd = {.type = DISPLAY_CMD_RESET};
+    post(&cmd);
+}
+
+void display_clear(void) {
+    display_cmd cmd = {.type = DISPLAY_CMD_CLEAR};
+    post(&cmd);
+}
+
+// Exibe 4 linhas de texto. Os ponteiros são copiados, mas as strings precisam
+// continuar válidas até serem desenhadas (literais, na prática).
+void display_text(const char *const text[DISPLAY_LINES]) {
+    display_cmd cmd = {.type = DISPLAY_CMD_TEXT};
+    for (uint i = 0; i < DISPLAY_LINES; i++)
+        cmd.text[i] = text[i];
+    post(&cmd);
+}
+
+// Exibe uma tela pronta, rasterizada na compilação (screens.h). O quadro é
+// enviado como está na flash, sem compor nem copiar; repetir a tela que já está
+// no painel não gera tráfego.
+void display_screen(const uint8_t *frame) {
+    display_cmd cmd = {.type = DISPLAY_CMD_SCREEN, .frame = frame};
+    post(&cmd);
+}
+
+// Letreiro: o texto corre para a esquerda na linha `line`, sem parar, até o
+// próximo comando. A string precisa continuar válida enquanto rola.
+void display_marquee(const char *text, uint line) {
+    display_cmd cmd = {.type = DISPLAY_CMD_MARQUEE, .line = line % DISPLAY_LINES};
+    cmd.text[0] = text;
+    post(&cmd);
+}
+
+// Rola `count` linhas de texto para cima, em ciclo, até o próximo comando. O
+// vetor e as strings precisam continuar válidos enquanto rolam.
+void display_scroll_lines(const char *const *lines, uint count) {
+    display_cmd cmd = {.type = DISPLAY_CMD_SCROLL, .line = count, .lines = lines};
+    post(&cmd);
+}
+
+// Apaga ou acende o painel, sem perder o conteúdo. Interrompe a rolagem.
+void display_power(bool on) {
+    display_cmd cmd = {.type = DISPLAY_CMD_POWER, .line = on};
+    post(&cmd);
+}
+
+// Troca o clk_sys na ordem dos comandos: os anteriores saem no clock antigo e
+// os seguintes no novo, sem envio em andamento durante a troca. Com wait, só
+// volta com o clock novo já valendo, para o PWM que o chamador liga em
+// seguida: espera lugar na fila em vez de descartar, e o núcleo 1 chegar ao
+// comando.
+void display_set_sys_clock(uint32_t khz, bool wait) {
+    display_cmd cmd = {.type = DISPLAY_CMD_CLOCK, .khz = khz};
+
+    if (!wait || !core1_running) {
+        if (post(&cmd))  // Sem o núcleo 1, já executado
+            clock_posted++;
+        return;
+    }
+    cmd.post_us = time_us_32();
+    while (!queue_try_add(&display_queue, &cmd))
+        __wfe();  // O núcleo 1 tira um comando e sinaliza
+    clock_posted++;
+    while (clock_done != clock_posted)
+        __wfe();
+}
+
+// Avança envios assíncronos pendentes e a rolagem quando o display roda neste núcleo
+void display_poll(void) {
+    uint32_t next_us;
+
+    if (!core1_running && SSD1306_flush_poll())
+        scroll_poll(&next_us);
+}
+
+void display_get_stats(display_stats *stats) {
+    stats->count = stat_count;
+    stats->last_us = stat_last_us;
+    stats->max_us = stat_max_us;
+    stats->dropped = stat_dropped;
+}
+
+// Uma linha no relatório do comando 's':
+//   D cmds=<n> last_us=<t> max_us=<t> dropped=<n> multicore=<0|1>
+void display_print_report(void) {
+    display_stats st;
+    display_get_stats(&st);
+
+    printf("D cmds=%lu last_us=%lu max_us=%lu dropped=%lu multicore=%d\n", (unsigned long)st.count,
+           (unsigned long)st.last_us, (unsigned long)st.max_us, (unsigned long)st.dropped, DISPLAY_MULTICORE);
+}
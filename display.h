@@ -0,0 +1,48 @@
+#ifndef DISPLAY_H_
+#define DISPLAY_H_
+
+#include "pico/stdlib.h"
+#include "ssd1306.h"
+
+// Camada de exibição do quiosque. Com DISPLAY_MULTICORE, a composição das telas
+// e o envio pelo I2C rodam no núcleo 1, alimentado por uma fila de comandos; o
+// núcleo 0 fica livre para botões, joystick e buzzer. Sem ela, os mesmos
+// comandos são executados na hora, por quem chamou.
+
+#ifndef DISPLAY_MULTICORE
+#define DISPLAY_MULTICORE 1
+#endif
+
+#define DISPLAY_LINES 4       // Linhas de texto por tela
+#define DISPLAY_QUEUE_LEN 8   // Comandos pendentes entre os núcleos
+
+// Rolagem. Letreiros que cabem na largura e até 8 linhas na vertical rolam no
+// próprio controlador; conteúdo maior é redesenhado por software a cada passo.
+#define DISPLAY_MARQUEE_STEP_MS 20                              // 1 pixel por passo, por software
+#define DISPLAY_MARQUEE_GAP 24                                  // Pixels entre o fim e o novo início
+#define DISPLAY_MARQUEE_HW_INTERVAL SSD1306_SCROLL_4_FRAMES     // Ritmo próximo ao do software
+#define DISPLAY_SCROLL_STEP_MS 60                               // 1 linha de pixels por passo
+#define DISPLAY_SCROLL_PAUSE_MS 1000                            // Antes de começar a rolar
+
+// Latência entre postar um comando e terminar de executá-lo
+typedef struct {
+    uint32_t count;    // Comandos executados
+    uint32_t last_us;
+    uint32_t max_us;
+    uint32_t dropped;  // Comandos perdidos por fila cheia
+} display_stats;
+
+extern void display_init(uint8_t *buf, struct render_area *frame_area);
+extern void display_reset(void);
+extern void display_clear(void);
+extern void display_text(const char *const text[DISPLAY_LINES]);
+extern void display_screen(const uint8_t *frame);
+extern void display_marquee(const char *text, uint line);
+extern void display_scroll_lines(const char *const *lines, uint count);
+extern void display_power(bool on);
+extern void display_set_sys_clock(uint32_t khz, bool wait);
+extern void display_poll(void);
+extern void display_get_stats(display_stats *stats);
+extern void display_print_report(void);
+
+#endif /* DISPLAY_H_ */
@@ -0,0 +1,225 @@
+#include <stdio.h>
+#include <ctype.h>
+#include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
+#include "pico/stdio/driver.h"
+#include "tusb.h"
+#include "attendance.h"
+#include "export.h"
+
+#define EXPORT_HDR_LEN 8
+#define EXPORT_CMD_DIGITS 8
+
+// CRC-32 do zlib (polinômio refletido 0xEDB88320), meio byte por consulta: a
+// tabela fica em 64 bytes e ainda dá poucos ciclos por byte enviado
+static const uint32_t crc32_nibble[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+// Ocupa o lugar de um registro que sumiu da flash entre a contagem do lote e o
+// envio (setor apagado pelo anel): o lote mantém o tamanho anunciado e o
+// leitor o descarta como posição vazia
+static const uint8_t erased_record[sizeof(attendance_record)] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+
+static bool active = false;
+static attendance_iter iter;       // Próximo registro a enviar
+static uint batch_left;            // Registros do lote atual ainda não iniciados
+static bool crc_sent, end_sent;
+
+// Pedaço sendo enviado: o cabeçalho, um registro na flash ou o CRC
+static const uint8_t *chunk;
+static uint chunk_left;
+static uint8_t hdr[EXPORT_HDR_LEN];
+static uint8_t crc_buf[4];
+static uint32_t crc;
+
+static uint32_t start_us, progress_us;
+static uint32_t sent_bytes, sent_records;
+
+static int cmd_digits = -1;  // Dígitos do cursor já recebidos; -1 fora de um comando
+static uint32_t cmd_cursor;
+
+static export_stats stats;
+
+static uint32_t crc32_update(uint32_t c, const uint8_t *p, uint len) {
+    while (len--) {
+        c ^= *p++;
+        c = (c >> 4) ^ crc32_nibble[c & 0xF];
+        c = (c >> 4) ^ crc32_nibble[c & 0xF];
+    }
+    return c;
+}
+
+static void put_le32(uint8_t *p, uint32_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+// Conta os registros do próximo lote e monta o cabeçalho. Sem registros, o
+// quadro é o de fim, com o cursor para a próxima exportação.
+static void start_frame(void) {
+    attendance_iter peek = iter;
+    const attendance_record *first = attendance_iter_next(&peek);
+    uint n = 0;
+
+    if (first)
+        for (n = 1; n < EXPORT_BATCH_RECORDS && attendance_iter_next(&peek); n++)
+            ;
+
+    uint len = n * sizeof(attendance_record);
+    hdr[0] = EXPORT_MAGIC;
+    hdr[1] = n ? EXPORT_BATCH : EXPORT_END;
+    hdr[2] = len;
+    hdr[3] = len >> 8;
+    put_le32(hdr + 4, n ? first->seq : iter.end_seq);
+
+    end_sent = !n;
+    batch_left = n;
+    sent_records += n;
+    crc = 0xFFFFFFFF;
+    crc_sent = false;
+    chunk = hdr;
+    chunk_left = EXPORT_HDR_LEN;
+}
+
+// Passa ao próximo pedaço; false depois do CRC do quadro de fim
+static bool next_chunk(void) {
+    if (batch_left) {
+        const attendance_record *r = attendance_iter_next(&iter);
+        chunk = r ? (const uint8_t *)r : erased_record;
+        chunk_left = sizeof(attendance_record);
+        batch_left--;
+        return true;
+    }
+    if (!crc_sent) {
+        put_le32(crc_buf, ~crc);
+        chunk = crc_buf;
+        chunk_left = sizeof(crc_buf);
+        crc_sent = true;
+        return true;
+    }
+    if (end_sent)
+        return false;
+    start_frame();
+    return true;
+}
+
+static void start(uint32_t cursor) {
+    attendance_iter_begin(&iter, cursor);
+    stdio_set_driver_enabled(&stdio_usb, false);  // Nada de texto no meio dos quadros
+
+    active = true;
+    crc_sent = true;  // Nenhum quadro aberto: a primeira chamada monta o primeiro
+    end_sent = false;
+    batch_left = 0;
+    chunk_left = 0;
+    sent_bytes = sent_records = 0;
+    start_us = progress_us = time_us_32();
+}
+
+static void finish(bool ok) {
+    active = false;
+    stdio_set_driver_enabled(&stdio_usb, true);
+
+    if (!ok) {
+        stats.aborted++;
+        return;
+    }
+    stats.exports++;
+    stats.records = sent_records;
+    stats.bytes = sent_bytes;
+    stats.last_us = time_us_32() - start_us;
+}
+
+// Recebe um caractere do console USB. O cursor vem em hexadecimal maiúsculo,
+// já que 'c' é um comando do trace. Retorna true quando um comando completo
+// iniciou uma exportação; a partir daí, chamar export_poll até EXPORT_IDLE.
+bool export_command(int ch) {
+    if (ch == 'x') {
+        cmd_digits = 0;
+        cmd_cursor = 0;
+        return false;
+    }
+    if (cmd_digits < 0 || !(isdigit(ch) || (ch >= 'A' && ch <= 'F'))) {
+        cmd_digits = -1;
+        return false;
+    }
+
+    cmd_cursor = cmd_cursor << 4 | (isdigit(ch) ? ch - '0' : ch - 'A' + 10);
+    if (++cmd_digits < EXPORT_CMD_DIGITS)
+        return false;
+    cmd_digits = -1;
+    if (active)
+        return false;
+    start(cmd_cursor);
+    return true;
+}
+
+// Envia o que couber na FIFO da USB, até EXPORT_CHUNK bytes, e volta: os lotes
+// andam entre as outras tarefas, sem segurar os botões ou o display.
+//
+// A escrita passa pelo driver stdio_usb, que toma o stdio_usb_mutex contra o
+// tud_task() da IRQ e não traduz CR/LF (isso é do printf). Cada pedaço cabe no
+// espaço livre da FIFO, que só cresce enquanto o texto está desligado, então o
+// driver nunca fica esperando o computador.
+export_state export_poll(void) {
+    if (!active)
+        return EXPORT_IDLE;
+    if (!stdio_usb_connected()) {
+        finish(false);
+        return EXPORT_IDLE;
+    }
+
+    uint32_t room = tud_cdc_write_available();
+    uint budget = MIN(room, EXPORT_CHUNK);
+    uint sent = 0;
+
+    while (sent < budget) {
+        if (!chunk_left && !next_chunk()) {
+            sent_bytes += sent;
+            finish(true);
+            return EXPORT_IDLE;
+        }
+
+        uint n = MIN(chunk_left, budget - sent);
+        stdio_usb.out_chars((const char *)chunk, n);
+        if (chunk != crc_buf)
+            crc = crc32_update(crc, chunk, n);
+        chunk += n;
+        chunk_left -= n;
+        sent += n;
+    }
+    sent_bytes += sent;
+
+    uint32_t now = time_us_32();
+    if (sent) {
+        progress_us = now;
+        return EXPORT_SENDING;
+    }
+    if (now - progress_us >= EXPORT_STALL_MS * 1000u)
+        finish(false);  // O computador parou de ler; retoma depois pelo cursor
+    return active ? EXPORT_WAITING : EXPORT_IDLE;
+}
+
+bool export_active(void) {
+    return active;
+}
+
+void export_get_stats(export_stats *out) {
+    *out = stats;
+}
+
+// Uma linha no relatório do comando 's':
+//   X exports=<n> aborted=<n> records=<n> bytes=<n> last_ms=<t> kb_s=<v>
+void export_print_report(void) {
+    uint32_t kb_s = stats.last_us ? (uint32_t)((uint64_t)stats.bytes * 1000 / stats.last_us) : 0;
+
+    printf("X exports=%lu aborted=%lu records=%lu bytes=%lu last_ms=%lu kb_s=%lu\n", (unsigned long)stats.exports,
+           (unsigned long)stats.aborted, (unsigned long)stats.records, (unsigned long)stats.bytes,
+           (unsigned long)(stats.last_us / 1000), (unsigned long)kb_s);
+}
@@ -0,0 +1,50 @@
+#ifndef EXPORT_H_
+#define EXPORT_H_
+
+#include "pico/stdlib.h"
+
+// Exportação do registro de presença pela USB (CDC), em binário. O computador
+// envia "x" e 8 dígitos hexadecimais maiúsculos com o cursor (o seq do primeiro
+// registro desejado); a placa responde com lotes e termina com um quadro de fim:
+//
+//   u8  EXPORT_MAGIC
+//   u8  tipo: EXPORT_BATCH ou EXPORT_END
+//   u16 bytes de dados (EXPORT_BATCH: registros x 16; EXPORT_END: 0)
+//   u32 EXPORT_BATCH: seq do primeiro registro; EXPORT_END: cursor para retomar
+//   ... registros (attendance_record, com o CRC-8 de cada um)
+//   u32 CRC-32 (o do zlib) do cabeçalho e dos dados
+//
+// Tudo em little-endian. Os registros saem direto da flash para a FIFO da USB,
+// um pedaço por chamada de export_poll, sem montar o lote na RAM. Durante a
+// exportação o stdio pela USB fica desligado, para nenhum printf se misturar
+// aos quadros. Leitor para Linux: tools/attendance_export.py.
+
+#define EXPORT_MAGIC 0xA7
+#define EXPORT_BATCH 1
+#define EXPORT_END 2
+
+#define EXPORT_BATCH_RECORDS 64  // 1 KB de dados por lote
+#define EXPORT_CHUNK 1024        // Bytes no máximo por chamada de export_poll
+#define EXPORT_STALL_MS 2000     // Sem o computador ler por este tempo, desiste
+
+typedef enum {
+    EXPORT_IDLE,     // Nada a enviar
+    EXPORT_SENDING,  // Enviou nesta chamada: chamar de novo logo
+    EXPORT_WAITING   // FIFO cheia: chamar de novo em 1 ms
+} export_state;
+
+typedef struct {
+    uint32_t exports;    // Exportações concluídas
+    uint32_t aborted;    // Interrompidas (desconexão ou computador parado)
+    uint32_t records;    // Da última exportação
+    uint32_t bytes;
+    uint32_t last_us;    // Duração da última exportação
+} export_stats;
+
+extern bool export_command(int ch);
+extern export_state export_poll(void);
+extern bool export_active(void);
+extern void export_get_stats(export_stats *stats);
+extern void export_print_report(void);
+
+#endif /* EXPORT_H_ */
@@ -0,0 +1,26 @@
+# Font atlases: fonts/bitdog8.txt is compiled into const tables in flash by
+# tools/fontgen.py (Python 3, which the Pico SDK build already needs). Link
+# bitdoglab_fonts to get ssd1306_fonts.h and the tables.
+
+find_package(Python3 REQUIRED COMPONENTS Interpreter)
+
+set(BITDOGLAB_FONTS_DIR ${CMAKE_CURRENT_LIST_DIR})
+set(BITDOGLAB_FONTS_OUT ${CMAKE_CURRENT_BINARY_DIR}/fonts)
+
+add_custom_command(
+  OUTPUT ${BITDOGLAB_FONTS_OUT}/ssd1306_fonts.c ${BITDOGLAB_FONTS_OUT}/ssd1306_fonts.h
+  COMMAND ${CMAKE_COMMAND} -E make_directory ${BITDOGLAB_FONTS_OUT}
+  COMMAND ${Python3_EXECUTABLE} ${BITDOGLAB_FONTS_DIR}/../tools/fontgen.py
+          ${BITDOGLAB_FONTS_DIR}/bitdog8.txt
+          ${BITDOGLAB_FONTS_OUT}/ssd1306_fonts.c ${BITDOGLAB_FONTS_OUT}/ssd1306_fonts.h
+          ssd1306_font_8x8:fixed ssd1306_font_8x8_prop:proportional
+  DEPENDS ${BITDOGLAB_FONTS_DIR}/bitdog8.txt ${BITDOGLAB_FONTS_DIR}/../tools/fontgen.py
+  VERBATIM
+)
+
+add_library(bitdoglab_fonts STATIC ${BITDOGLAB_FONTS_OUT}/ssd1306_fonts.c)
+
+target_include_directories(bitdoglab_fonts PUBLIC
+  ${BITDOGLAB_FONTS_OUT}
+  ${BITDOGLAB_FONTS_DIR}/..
+)
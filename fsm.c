@@ -0,0 +1,58 @@
+#include "pico/stdlib.h"
+#include "fsm.h"
+
+static void enter(fsm *m, uint8_t to, uint32_t time_us) {
+    m->state = to;
+    m->entered_us = time_us;
+    if (m->def->states[to].on_entry)
+        m->def->states[to].on_entry(m);
+}
+
+// Coloca a máquina no estado inicial, executando a ação de entrada dele
+void fsm_start(fsm *m, const fsm_def *def, uint32_t now_us) {
+    m->def = def;
+    enter(m, def->initial, now_us);
+}
+
+// Entrega um evento. Devolve true se houve transição. As ações não devem
+// despachar eventos na mesma máquina: a transição ainda está em andamento.
+bool fsm_dispatch(fsm *m, uint8_t event, uint32_t time_us) {
+    const fsm_def *def = m->def;
+    uint8_t from = m->state;
+
+    if (event >= def->num_events)
+        return false;
+
+    const fsm_transition *t = &def->table[from * def->num_events + event];
+    bool taken = !t->guard || t->guard(m, time_us);
+    uint8_t to = taken ? t->to : t->otherwise;
+    if (to == FSM_NONE)
+        return false;
+
+    if (def->states[from].on_exit)
+        def->states[from].on_exit(m);
+    if (taken && t->action)
+        t->action(m);
+    if (m->observer)
+        m->observer(m, from, event, to, time_us);
+    enter(m, to, time_us);
+    return true;
+}
+
+// Gera o evento de tempo esgotado do estado atual, se for o caso. O instante do
+// evento é o prazo, não o da consulta, para que atrasos não se acumulem.
+bool fsm_poll(fsm *m, uint32_t now_us) {
+    uint32_t timeout = m->def->states[m->state].timeout_us;
+
+    if (!timeout || now_us - m->entered_us < timeout)
+        return false;
+    return fsm_dispatch(m, m->def->timeout_event, m->entered_us + timeout);
+}
+
+const char *fsm_state_name(const fsm *m, uint8_t state) {
+    return state < m->def->num_states ? m->def->states[state].name : "?";
+}
+
+const char *fsm_event_name(const fsm *m, uint8_t event) {
+    return event < m->def->num_events ? m->def->event_names[event] : "?";
+}
@@ -0,0 +1,66 @@
+#ifndef FSM_H_
+#define FSM_H_
+
+#include "pico/stdlib.h"
+
+// Máquina de estados finitos dirigida por tabelas. Estados (com ações de
+// entrada e saída e um tempo limite opcional) e transições ficam em tabelas
+// const, na flash; o despacho de um evento é uma indexação direta
+// [estado][evento], sem buscas e sem esperas. O tempo vem sempre de quem chama,
+// então a mesma máquina roda no host a partir de um registro de eventos.
+
+#define FSM_NONE 0  // Estado 0 é reservado: célula vazia ou "ignorar o evento"
+
+typedef struct fsm fsm;
+
+// Condição de uma transição, avaliada com o instante do evento
+typedef bool (*fsm_guard)(const fsm *m, uint32_t time_us);
+typedef void (*fsm_action)(fsm *m);
+
+typedef struct {
+    const char *name;
+    fsm_action on_entry;
+    fsm_action on_exit;
+    uint32_t timeout_us;  // 0 = sem tempo limite; ao esgotar gera timeout_event
+} fsm_state_def;
+
+// Célula da tabela. Se a condição falhar, vale "otherwise" (FSM_NONE = ignora).
+typedef struct {
+    uint8_t to;
+    uint8_t otherwise;
+    fsm_guard guard;      // NULL = sempre
+    fsm_action action;    // Entre a saída do estado atual e a entrada no próximo
+} fsm_transition;
+
+typedef struct {
+    const char *name;
+    const fsm_state_def *states;      // num_states entradas, a 0 sem uso
+    const fsm_transition *table;      // num_states * num_events células
+    const char *const *event_names;
+    uint8_t num_states;
+    uint8_t num_events;
+    uint8_t initial;
+    uint8_t timeout_event;
+} fsm_def;
+
+// Chamado a cada transição, com o instante do evento, para registro e depuração
+typedef void (*fsm_observer)(const fsm *m, uint8_t from, uint8_t event, uint8_t to, uint32_t time_us);
+
+struct fsm {
+    const fsm_def *def;
+    uint8_t state;
+    uint32_t entered_us;  // Instante do evento que levou ao estado atual
+    fsm_observer observer;
+    void *ctx;
+};
+
+// Célula da tabela de def para (estado, evento), para inicializadores designados
+#define FSM_CELL(num_events, state, event) [(state) * (num_events) + (event)]
+
+extern void fsm_start(fsm *m, const fsm_def *def, uint32_t now_us);
+extern bool fsm_dispatch(fsm *m, uint8_t event, uint32_t time_us);
+extern bool fsm_poll(fsm *m, uint32_t now_us);
+extern const char *fsm_state_name(const fsm *m, uint8_t state);
+extern const char *fsm_event_name(const fsm *m, uint8_t event);
+
+#endif /* FSM_H_ */
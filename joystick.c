@@ -0,0 +1,83 @@
+#include <stdlib.h>
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "joystick.h"
+
+// Amostras intercaladas X, Y, X, Y... O alinhamento é exigido pelo modo ring do DMA.
+static volatile uint16_t samples[JOYSTICK_RING_LEN] __attribute__((aligned(1 << JOYSTICK_RING_BITS)));
+
+static uint16_t center_x = 2048, center_y = 2048;
+static bool moved = false;
+
+// Média de algumas conversões avulsas, usada só na calibração
+static uint16_t average_single(uint input) {
+    uint32_t sum = 0;
+    adc_select_input(input);
+    for (int i = 0; i < 8; i++)
+        sum += adc_read();
+    return sum / 8;
+}
+
+// Configura o ADC e o DMA uma única vez; depois disso a amostragem é contínua
+void joystick_init(void) {
+    adc_init();
+    adc_gpio_init(JOYSTICK_X_PIN);
+    adc_gpio_init(JOYSTICK_Y_PIN);
+
+    // Calibra o centro com o joystick em repouso; valores absurdos ficam no meio da escala
+    uint16_t x = average_single(0), y = average_single(1);
+    if (x > 1500 && x < 2600)
+        center_x = x;
+    if (y > 1500 && y < 2600)
+        center_y = y;
+
+    adc_select_input(0);
+    adc_set_round_robin(0x3);                 // Alterna entre ADC0 e ADC1
+    adc_fifo_setup(true, true, 1, false, false);  // FIFO com DREQ a cada amostra, 12 bits
+    adc_set_clkdiv(48000000.0f / JOYSTICK_SAMPLE_HZ - 1);
+
+    // Dois canais encadeados um ao outro: cada um percorre o buffer inteiro uma vez,
+    // termina de volta no início (modo ring) e dispara o outro, indefinidamente
+    int chan[2] = {dma_claim_unused_channel(true), dma_claim_unused_channel(true)};
+    for (int i = 0; i < 2; i++) {
+        dma_channel_config c = dma_channel_get_default_config(chan[i]);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+        channel_config_set_read_increment(&c, false);
+        channel_config_set_write_increment(&c, true);
+        channel_config_set_ring(&c, true, JOYSTICK_RING_BITS);
+        channel_config_set_dreq(&c, DREQ_ADC);
+        channel_config_set_chain_to(&c, chan[1 - i]);
+        dma_channel_configure(chan[i], &c, samples, &adc_hw->fifo, JOYSTICK_RING_LEN, false);
+    }
+
+    for (uint i = 0; i < JOYSTICK_RING_LEN; i++)
+        samples[i] = i % 2 ? center_y : center_x;  // Evita leituras falsas antes do primeiro ciclo
+
+    dma_channel_start(chan[0]);
+    adc_run(true);
+}
+
+// Média móvel das últimas amostras de cada eixo
+void joystick_read(uint16_t *x, uint16_t *y) {
+    uint32_t sum_x = 0, sum_y = 0;
+    for (uint i = 0; i < JOYSTICK_RING_LEN; i += 2) {
+        sum_x += samples[i];
+        sum_y += samples[i + 1];
+    }
+    *x = sum_x / (JOYSTICK_RING_LEN / 2);
+    *y = sum_y / (JOYSTICK_RING_LEN / 2);
+}
+
+// Retorna true enquanto o joystick estiver fora do centro, com histerese
+bool joystick_moved(void) {
+    uint16_t x, y;
+    joystick_read(&x, &y);
+
+    int dx = abs((int)x - center_x);
+    int dy = abs((int)y - center_y);
+    int limit = moved ? JOYSTICK_EXIT_DELTA : JOYSTICK_ENTER_DELTA;
+
+    moved = dx > limit || dy > limit;
+    return moved;
+}
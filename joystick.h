@@ -0,0 +1,25 @@
+#ifndef JOYSTICK_H_
+#define JOYSTICK_H_
+
+#include "pico/stdlib.h"
+
+// Joystick por amostragem contínua: o ADC converte X e Y em round-robin e o
+// DMA grava as amostras num buffer circular, sem intervenção da CPU. A leitura
+// só calcula a média das últimas amostras já gravadas.
+
+#define JOYSTICK_X_PIN 26         // GPIO26 = ADC0, eixo X
+#define JOYSTICK_Y_PIN 27         // GPIO27 = ADC1, eixo Y
+#define JOYSTICK_RING_BITS 5      // Buffer de 2^5 bytes = 16 amostras (8 por eixo)
+#define JOYSTICK_RING_LEN ((1 << JOYSTICK_RING_BITS) / sizeof(uint16_t))
+#define JOYSTICK_SAMPLE_HZ 2000   // Taxa total de conversão (os dois eixos)
+
+// Histerese em torno do centro calibrado: o movimento é detectado ao passar de
+// ENTER e só termina ao voltar para dentro de EXIT
+#define JOYSTICK_ENTER_DELTA 1000
+#define JOYSTICK_EXIT_DELTA 600
+
+extern void joystick_init(void);
+extern void joystick_read(uint16_t *x, uint16_t *y);
+extern bool joystick_moved(void);
+
+#endif /* JOYSTICK_H_ */
@@ -0,0 +1,60 @@
+#include "pico/stdlib.h"
+#include "kiosk.h"
+
+const char *const event_names[NUM_EVENTS] = {
+    "TIMEOUT", "A_PRESS", "A_RELEASE", "B_PRESS", "B_RELEASE", "JOYSTICK", "TICK"
+};
+
+// O botão ficou pressionado por tempo suficiente para valer (desde a entrada no estado)
+static bool held_long(const fsm *m, uint32_t time_us) {
+    return time_us - m->entered_us > DEBOUNCE_US;
+}
+
+// Fluxo de presença: A confirma, B encerra a sessão e reinicia após 10 segundos.
+// Toques durante o reinício não têm transição e são descartados.
+static const fsm_state_def kiosk_states[NUM_KIOSK_STATES] = {
+    [ST_IDLE] = {"IDLE"},
+    [ST_DEBOUNCING_A] = {"DEBOUNCING_A", show_button_a, NULL, DEBOUNCE_US},
+    [ST_RELEASE_A] = {"RELEASE_A"},
+    [ST_DEBOUNCING_B] = {"DEBOUNCING_B", show_button_b, NULL, DEBOUNCE_US},
+    [ST_RELEASE_B] = {"RELEASE_B"},
+    [ST_RESETTING] = {"RESETTING", reset_session, NULL, 5000000},    // Mensagem de aguarde por 5 s
+    [ST_RESTARTING] = {"RESTARTING", restart_system, NULL, 5000000}, // Mensagem de reinício por 5 s
+};
+
+#define KIOSK(state, event) FSM_CELL(NUM_EVENTS, state, event)
+
+static const fsm_transition kiosk_table[NUM_KIOSK_STATES * NUM_EVENTS] = {
+    KIOSK(ST_IDLE, EV_A_PRESS) = {ST_DEBOUNCING_A},
+    KIOSK(ST_IDLE, EV_B_PRESS) = {ST_DEBOUNCING_B},
+    // Solto antes do tempo mínimo não vale; depois dele, vale na hora
+    KIOSK(ST_DEBOUNCING_A, EV_A_RELEASE) = {ST_IDLE, ST_IDLE, held_long, confirm_presence},
+    KIOSK(ST_DEBOUNCING_A, EV_TIMEOUT) = {ST_RELEASE_A},
+    KIOSK(ST_RELEASE_A, EV_A_RELEASE) = {ST_IDLE, FSM_NONE, NULL, confirm_presence},
+    KIOSK(ST_DEBOUNCING_B, EV_B_RELEASE) = {ST_RESETTING, ST_IDLE, held_long},
+    KIOSK(ST_DEBOUNCING_B, EV_TIMEOUT) = {ST_RELEASE_B},
+    KIOSK(ST_RELEASE_B, EV_B_RELEASE) = {ST_RESETTING},
+    KIOSK(ST_RESETTING, EV_TIMEOUT) = {ST_RESTARTING},
+    KIOSK(ST_RESTARTING, EV_TIMEOUT) = {ST_IDLE, FSM_NONE, NULL, restart_done},
+};
+
+const fsm_def kiosk_def = {
+    "kiosk", kiosk_states, kiosk_table, event_names, NUM_KIOSK_STATES, NUM_EVENTS, ST_IDLE, EV_TIMEOUT
+};
+
+// Joystick: movido acende o LED 12, que apaga quando o botão A não está pressionado
+static const fsm_state_def joystick_states[NUM_JOY_STATES] = {
+    [ST_JOY_IDLE] = {"IDLE"},
+    [ST_JOY_HOLD] = {"HOLD", joystick_led_on, joystick_led_off},
+};
+
+#define JOY(state, event) FSM_CELL(NUM_EVENTS, state, event)
+
+static const fsm_transition joystick_table[NUM_JOY_STATES * NUM_EVENTS] = {
+    JOY(ST_JOY_IDLE, EV_JOYSTICK) = {ST_JOY_HOLD},
+    JOY(ST_JOY_HOLD, EV_TICK) = {ST_JOY_IDLE, FSM_NONE, button_a_up},
+};
+
+const fsm_def joystick_def = {
+    "joystick", joystick_states, joystick_table, event_names, NUM_JOY_STATES, NUM_EVENTS, ST_JOY_IDLE, EV_TIMEOUT
+};
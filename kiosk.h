@@ -0,0 +1,61 @@
+#ifndef KIOSK_H_
+#define KIOSK_H_
+
+#include "pico/stdlib.h"
+#include "fsm.h"
+
+// Máquinas de estado do quiosque: o fluxo de presença (botões A e B) e o
+// joystick. As tabelas ficam aqui, sem dependência de hardware, para que o
+// host reproduza um registro de transições (linhas F) nas mesmas tabelas; as
+// ações e a condição do botão A são do firmware (BitDogLab.c).
+
+// Tempo mínimo pressionado para um botão valer
+#define DEBOUNCE_US 50000
+
+// Eventos das duas máquinas
+typedef enum {
+    EV_TIMEOUT,    // Tempo limite do estado esgotado
+    EV_A_PRESS,
+    EV_A_RELEASE,
+    EV_B_PRESS,
+    EV_B_RELEASE,
+    EV_JOYSTICK,   // Joystick fora do centro
+    EV_TICK,       // Leitura periódica das entradas
+    NUM_EVENTS
+} kiosk_event;
+
+// Estados do fluxo de presença
+typedef enum {
+    ST_IDLE = 1,      // Aguardando um botão
+    ST_DEBOUNCING_A,  // A pressionado, ainda sem o tempo mínimo
+    ST_RELEASE_A,     // A valeu, espera soltar
+    ST_DEBOUNCING_B,
+    ST_RELEASE_B,
+    ST_RESETTING,     // Dados reiniciados, aguardando
+    ST_RESTARTING,    // Display reiniciado, mensagem de agradecimento
+    NUM_KIOSK_STATES
+} kiosk_state;
+
+// Estados do joystick
+typedef enum {
+    ST_JOY_IDLE = 1,
+    ST_JOY_HOLD,      // Movido, LED aceso enquanto o botão A estiver pressionado
+    NUM_JOY_STATES
+} joystick_state;
+
+extern const char *const event_names[NUM_EVENTS];
+extern const fsm_def kiosk_def;
+extern const fsm_def joystick_def;
+
+// Ações e condição, definidas pelo firmware
+extern void show_button_a(fsm *m);
+extern void show_button_b(fsm *m);
+extern void confirm_presence(fsm *m);
+extern void reset_session(fsm *m);
+extern void restart_system(fsm *m);
+extern void restart_done(fsm *m);
+extern void joystick_led_on(fsm *m);
+extern void joystick_led_off(fsm *m);
+extern bool button_a_up(const fsm *m, uint32_t time_us);
+
+#endif /* KIOSK_H_ */
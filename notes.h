@@ -1,118 +1,44 @@
-#define NOTE_C4 29886
-#define NOTE_Cs4 28294
-#define NOTE_C5 14929
-#define NOTE_C6 7465
-#define NOTE_D4 26795
-#define NOTE_D5 13298
-#define NOTE_DS4 25386
-#define NOTE_E4 24063
-#define NOTE_F4 22823
-#define NOTE_FS5 9561
-#define NOTE_Fs4 21663
-#define NOTE_G4 20579
-#define NOTE_G5 8966
-#define NOTE_GS5 9409
-#define NOTE_GS4 19569
-#define NOTE_A4 18630
-#define NOTE_AS4 177758
-#define NOTE_AS5 8380
-#define NOTE_AS3 33498
-#define NOTE_B4 16952
-
-#define SONG_B_LENGTH 129
-
-
-
-int melody[] = {
-    NOTE_G4, NOTE_C4, NOTE_DS4, NOTE_F4, NOTE_G4, NOTE_C4, NOTE_DS4, NOTE_F4,
-    NOTE_G4, NOTE_C4, NOTE_DS4, NOTE_F4, NOTE_G4, NOTE_C4, NOTE_DS4, NOTE_F4,
-    NOTE_G4, NOTE_C4, NOTE_E4, NOTE_F4, NOTE_G4, NOTE_C4, NOTE_E4, NOTE_F4,
-    NOTE_G4, NOTE_C4, NOTE_E4, NOTE_F4, NOTE_G4, NOTE_C4, NOTE_E4, NOTE_F4,
-    NOTE_G4, NOTE_C4,
-
-    NOTE_DS4, NOTE_F4, NOTE_G4, NOTE_C4, NOTE_DS4, NOTE_F4,
-    NOTE_D4,
-    NOTE_F4, NOTE_AS3,
-    NOTE_DS4, NOTE_D4, NOTE_F4, NOTE_AS3,
-    NOTE_DS4, NOTE_D4, NOTE_C4,
-
-    NOTE_G4, NOTE_C4,
-
-    NOTE_DS4, NOTE_F4, NOTE_G4, NOTE_C4, NOTE_DS4, NOTE_F4,
-    NOTE_D4,
-    NOTE_F4, NOTE_AS3,
-    NOTE_DS4, NOTE_D4, NOTE_F4, NOTE_AS3,
-    NOTE_DS4, NOTE_D4, NOTE_C4,
-    NOTE_G4, NOTE_C4,
-    NOTE_DS4, NOTE_F4, NOTE_G4, NOTE_C4, NOTE_DS4, NOTE_F4,
-
-    NOTE_D4,
-    NOTE_F4, NOTE_AS3,
-    NOTE_D4, NOTE_DS4, NOTE_D4, NOTE_AS3,
-    NOTE_C4,
-    NOTE_C5,
-    NOTE_AS4,
-    NOTE_C4,
-    NOTE_G4,
-    NOTE_DS4,
-    NOTE_DS4, NOTE_F4,
-    NOTE_G4,
-
-    NOTE_C5,
-    NOTE_AS4,
-    NOTE_C4,
-    NOTE_G4,
-    NOTE_DS4,
-    NOTE_DS4, NOTE_D4,
-    NOTE_C5, NOTE_G4, NOTE_GS4, NOTE_AS4, NOTE_C5, NOTE_G4, NOTE_GS4, NOTE_AS4,
-    NOTE_C5, NOTE_G4, NOTE_GS4, NOTE_AS4, NOTE_C5, NOTE_G4, NOTE_GS4, NOTE_AS4,
-
-    NOTE_GS5, NOTE_AS5, NOTE_C6, NOTE_G5, NOTE_GS5, NOTE_AS5,
-    NOTE_C6, NOTE_G5, NOTE_GS5, NOTE_AS5, NOTE_C6, NOTE_G5, NOTE_GS5, NOTE_AS5};
-
-int durations[] = {
-    8, 8, 16, 16, 8, 8, 16, 16,
-    8, 8, 16, 16, 8, 8, 16, 16,
-    8, 8, 16, 16, 8, 8, 16, 16,
-    8, 8, 16, 16, 8, 8, 16, 16,
-    4, 4,
-
-    16, 16, 4, 4, 16, 16,
-    1,
-    4, 4,
-    16, 16, 4, 4,
-    16, 16, 1,
-
-    4, 4,
-
-    16, 16, 4, 4, 16, 16,
-    1,
-    4, 4,
-    16, 16, 4, 4,
-    16, 16, 1,
-    4, 4,
-    16, 16, 4, 4, 16, 16,
-
-    2,
-    4, 4,
-    8, 8, 8, 8,
-    1,
-    2,
-    2,
-    2,
-    2,
-    2,
-    4, 4,
-    1,
-
-    2,
-    2,
-    2,
-    2,
-    2,
-    4, 4,
-    8, 8, 16, 16, 8, 8, 16, 16,
-    8, 8, 16, 16, 8, 8, 16, 16,
-
-    16, 16, 8, 8, 16, 16,
-    8, 16, 16, 16, 8, 8, 16, 16};
\ No newline at end of file
+#ifndef NOTES_H_
+#define NOTES_H_
+
+// Notas como valores de wrap do PWM do buzzer (clk_sys / 16 / frequência). Cada
+// entrada gera NOTE_<nome> = wrap e PITCH_<nome>, o índice usado pelo formato
+// compacto de song.h (PITCH_REST = 0 é a pausa). Só acrescente no fim, para não
+// mudar os índices das músicas já convertidas.
+#define NOTE_TABLE(X)   \
+    X(C4, 29886)        \
+    X(Cs4, 28294)       \
+    X(C5, 14929)        \
+    X(C6, 7465)         \
+    X(D4, 26795)        \
+    X(D5, 13298)        \
+    X(DS4, 25386)       \
+    X(E4, 24063)        \
+    X(F4, 22823)        \
+    X(FS5, 9561)        \
+    X(Fs4, 21663)       \
+    X(G4, 20579)        \
+    X(G5, 8966)         \
+    X(GS5, 9409)        \
+    X(GS4, 19569)       \
+    X(A4, 18630)        \
+    X(AS4, 17758)       \
+    X(AS5, 8380)        \
+    X(AS3, 33498)       \
+    X(B4, 16952)
+
+enum {
+#define NOTE_WRAP(name, wrap) NOTE_##name = wrap,
+    NOTE_TABLE(NOTE_WRAP)
+#undef NOTE_WRAP
+};
+
+enum {
+    PITCH_REST,
+#define NOTE_PITCH(name, wrap) PITCH_##name,
+    NOTE_TABLE(NOTE_PITCH)
+#undef NOTE_PITCH
+    NUM_PITCHES
+};
+
+#endif /* NOTES_H_ */
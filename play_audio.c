@@ -0,0 +1,150 @@
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "ssd1306.h"
+#include "play_audio.h"
+#include "tone.h"
+
+// Sequenciador de músicas em segundo plano, um por voz (buzzer), para tocar
+// melodias e harmonias ao mesmo tempo. Cada nota é entregue ao gerador de tons
+// e o fim dela é marcado por um alarme de hardware da voz, cujo callback (em
+// contexto de IRQ) já inicia a nota seguinte. As músicas são lidas da flash um
+// evento por vez. O laço principal nunca espera pelo áudio.
+
+typedef struct {
+    const song_t *song;
+    uint pin;
+    song_cursor cursor;
+    song_event note;  // Nota atual
+    uint index;       // Índice da nota atual nesta repetição
+    uint plays;       // Repetições completas
+    bool active;
+} seq_slot;
+
+// Prioridades de uma voz: só a mais alta ativa soa, as outras ficam paradas
+typedef struct {
+    seq_slot slots[SEQ_NUM_PRIORITIES];
+    seq_slot *current;  // Slot que está soando (NULL = silêncio)
+    alarm_id_t alarm;   // Alarme do fim da nota atual (0 = nenhum)
+} seq_voice;
+
+static seq_voice voices[TONE_VOICES];
+
+static seq_slot *highest_active_slot(seq_voice *v) {
+    for (int i = SEQ_NUM_PRIORITIES - 1; i >= 0; i--) {
+        if (v->slots[i].active)
+            return &v->slots[i];
+    }
+    return NULL;
+}
+
+// Toca a nota atual do slot mais prioritário da voz e retorna sua duração em us (0 = nada a tocar)
+static int64_t start_current_note(seq_voice *v) {
+    seq_slot *s = highest_active_slot(v);
+
+    if (v->current && v->current != s)
+        play_rest(v->current->pin);  // Silencia a música interrompida ou encerrada
+    v->current = s;
+    if (!s)
+        return 0;
+
+    if (s->note.wrap > 0)
+        play_note(s->pin, s->note.wrap);
+    else
+        play_rest(s->pin);
+
+    return s->note.dur_us;
+}
+
+// Carrega no slot a próxima nota, voltando ao início da música a cada repetição.
+// Retorna false quando a música termina (ou não tem nenhuma nota).
+static bool next_note(seq_slot *s) {
+    if (song_next(&s->cursor, &s->note)) {
+        s->index++;
+        return true;
+    }
+    s->plays++;
+    if (s->song->repeat && s->plays >= s->song->repeat)
+        return false;
+    song_begin(&s->cursor, s->song->words);
+    s->index = 0;
+    return song_next(&s->cursor, &s->note);
+}
+
+static int64_t seq_alarm_callback(alarm_id_t id, void *user_data) {
+    seq_voice *v = user_data;
+
+    if (!next_note(v->current))
+        v->current->active = false;
+
+    // Retornar um valor positivo reagenda o alarme a partir do disparo anterior,
+    // então a música não acumula atraso nota a nota
+    int64_t next_us = start_current_note(v);
+    if (next_us == 0)
+        v->alarm = 0;
+    return next_us;
+}
+
+// Recomeça a temporização da voz a partir da nota atual; chamada com interrupções desabilitadas
+static void restart_timing(seq_voice *v) {
+    if (v->alarm > 0)
+        cancel_alarm(v->alarm);
+    v->alarm = 0;
+
+    int64_t dur_us = start_current_note(v);
+    if (dur_us > 0)
+        v->alarm = add_alarm_in_us(dur_us, seq_alarm_callback, v, true);
+}
+
+// Toca a música no pino indicado, na prioridade indicada. Músicas em buzzers
+// diferentes soam juntas. Retorna false se a prioridade for inválida, o pino
+// não tiver voz ou a música não tiver nenhuma nota.
+bool sequencer_play(uint pin, const song_t *song, uint priority) {
+    seq_slot slot = {.song = song, .pin = pin, .active = true};
+    int voice = tone_voice(pin);
+
+    if (priority >= SEQ_NUM_PRIORITIES || !song || voice < 0)
+        return false;
+    song_begin(&slot.cursor, song->words);
+    if (!song_next(&slot.cursor, &slot.note))
+        return false;
+
+    seq_voice *v = &voices[voice];
+    uint32_t irq = save_and_disable_interrupts();
+    v->slots[priority] = slot;
+    if (!v->current || v->current <= &v->slots[priority])
+        restart_timing(v);
+    restore_interrupts(irq);
+    return true;
+}
+
+// Para a música da prioridade indicada em todas as vozes; em cada uma, uma de
+// prioridade menor retoma se houver
+void sequencer_stop(uint priority) {
+    if (priority >= SEQ_NUM_PRIORITIES)
+        return;
+
+    uint32_t irq = save_and_disable_interrupts();
+    for (uint i = 0; i < TONE_VOICES; i++) {
+        seq_voice *v = &voices[i];
+        v->slots[priority].active = false;
+        if (v->current == &v->slots[priority])
+            restart_timing(v);
+    }
+    restore_interrupts(irq);
+}
+
+bool sequencer_is_playing(uint priority) {
+    return sequencer_position(priority) >= 0;
+}
+
+// Posição (índice da nota atual, contando os trechos repetidos) da música da
+// prioridade indicada, na primeira voz que a toca; -1 se parada
+int sequencer_position(uint priority) {
+    if (priority >= SEQ_NUM_PRIORITIES)
+        return -1;
+    for (uint i = 0; i < TONE_VOICES; i++) {
+        if (voices[i].slots[priority].active)
+            return voices[i].slots[priority].index;
+    }
+    return -1;
+}
@@ -1,3 +1,30 @@
+#ifndef PLAY_AUDIO_H_
+#define PLAY_AUDIO_H_
+
+#include "pico/stdlib.h"
+#include "song.h"
+
+// Música para o sequenciador: eventos no formato compacto de song.h, em flash
+typedef struct {
+    const uint16_t *words;  // Terminada por SONG_END
+    uint repeat;            // Quantas vezes tocar (0 = repete até ser parada)
+} song_t;
+
+// Prioridades: uma música de prioridade maior interrompe a de menor, que
+// continua de onde parou quando a outra termina
+#define SEQ_PRIO_BACKGROUND 0
+#define SEQ_PRIO_ALERT 1
+#define SEQ_NUM_PRIORITIES 2
+
 extern int main_audio(uint8_t *buf, struct render_area *frame_area);
 extern void setup_audio();
-extern void read_buttons(uint8_t *buf, struct render_area *frame_area);
\ No newline at end of file
+extern void read_buttons();
+extern void play_note(uint pin, uint16_t wrap);
+extern void play_rest(uint pin);
+
+extern bool sequencer_play(uint pin, const song_t *song, uint priority);
+extern void sequencer_stop(uint priority);
+extern bool sequencer_is_playing(uint priority);
+extern int sequencer_position(uint priority);
+
+#endif /* PLAY_AUDIO_H_ */
@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "display.h"
+#include "power.h"
+#if POWER_DORMANT
+#include "pico/stdio_usb.h"
+#include "hardware/clocks.h"
+#include "hardware/pll.h"
+#include "hardware/xosc.h"
+#endif
+
+static const char *const state_names[POWER_NUM_STATES] = {"active", "idle"};
+
+static volatile power_state state = POWER_ACTIVE;  // Lido também pela IRQ dos botões
+static power_change_fn change_fn;
+static const uint *wake_pins;
+static uint num_wake_pins;
+
+static uint32_t last_activity_us;  // Última interação ou trabalho em andamento
+static uint64_t entered_us;        // Entrada no estado atual
+static power_stats stats;
+
+static void set_state(power_state to) {
+    uint64_t now = time_us_64();
+    power_state from = state;
+
+    stats.residency_us[from] += now - entered_us;
+    stats.entries[to]++;
+    entered_us = now;
+    state = to;
+    if (change_fn)
+        change_fn(from, to);
+}
+
+// O clk_sys troca pela fila do display (display_set_sys_clock), depois de o
+// painel apagar e antes de acender: nenhum envio pelo I2C fica no meio da troca,
+// e os divisores do I2C são refeitos para o clock novo. Os registros do PWM
+// contam ciclos do clk_sys, então ao acordar a volta aos 125 MHz é esperada:
+// uma nota tocada logo depois já sai na altura certa.
+static void enter_idle(void) {
+    display_power(false);
+    display_set_sys_clock(POWER_IDLE_SYS_KHZ, false);
+    set_state(POWER_IDLE);
+}
+
+static void leave_idle(void) {
+    display_set_sys_clock(POWER_ACTIVE_SYS_KHZ, true);
+    display_power(true);
+    set_state(POWER_ACTIVE);
+}
+
+#if POWER_DORMANT
+// Para o cristal até uma borda de descida num botão. Os PLLs são desligados e
+// clk_ref/clk_sys passam ao cristal antes; na volta, clocks_init refaz a
+// configuração padrão do boot. O toque que acorda não chega à fila dos botões.
+static void enter_dormant(void) {
+    clock_configure(clk_ref, CLOCKS_CLK_REF_CTRL_SRC_VALUE_XOSC_CLKSRC, 0, 12 * MHZ, 12 * MHZ);
+    clock_configure(clk_sys, CLOCKS_CLK_SYS_CTRL_SRC_VALUE_CLK_REF, 0, 12 * MHZ, 12 * MHZ);
+    clock_configure(clk_peri, 0, CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_XOSC_CLKSRC, 12 * MHZ, 12 * MHZ);
+    clock_stop(clk_usb);
+    clock_stop(clk_adc);
+    clock_stop(clk_rtc);
+    pll_deinit(pll_sys);
+    pll_deinit(pll_usb);
+
+    for (uint i = 0; i < num_wake_pins; i++)
+        gpio_set_dormant_irq_enabled(wake_pins[i], GPIO_IRQ_EDGE_FALL, true);
+    xosc_dormant();  // Retorna com o cristal estável após a borda
+    for (uint i = 0; i < num_wake_pins; i++) {
+        gpio_set_dormant_irq_enabled(wake_pins[i], GPIO_IRQ_EDGE_FALL, false);
+        gpio_acknowledge_irq(wake_pins[i], GPIO_IRQ_EDGE_FALL);
+    }
+
+    clocks_init();  // clk_sys de volta ao padrão; leave_idle refaz os divisores do I2C
+    stats.dormant_count++;
+}
+#endif
+
+// Guarda os pinos que acordam do modo dormente e a função chamada a cada troca
+// de estado (para ajustar o período das leituras, por exemplo)
+void power_init(const uint *pins, uint count, power_change_fn on_change) {
+    wake_pins = pins;
+    num_wake_pins = count;
+    change_fn = on_change;
+    last_activity_us = time_us_32();
+    entered_us = time_us_64();
+    stats.entries[POWER_ACTIVE] = 1;
+}
+
+// Interação do usuário no instante event_us. Se estava ocioso, acorda e mede a
+// latência desde o evento.
+void power_activity(uint32_t event_us) {
+    last_activity_us = time_us_32();
+    if (state == POWER_ACTIVE)
+        return;
+
+    leave_idle();
+    uint32_t latency = time_us_32() - event_us;
+    stats.wakes++;
+    stats.wake_last_us = latency;
+    if (latency > stats.wake_max_us)
+        stats.wake_max_us = latency;
+}
+
+// Chamada a cada leitura das entradas. busy indica trabalho em andamento (uma
+// etapa do fluxo, música tocando) que conta como interação.
+void power_poll(bool busy) {
+    uint32_t now = time_us_32();
+
+    if (busy) {
+        last_activity_us = now;
+        return;
+    }
+
+    switch (state) {
+        case POWER_ACTIVE:
+            if (now - last_activity_us >= POWER_BLANK_MS * 1000u)
+                enter_idle();
+            break;
+        case POWER_IDLE:
+#if POWER_DORMANT
+            // Com um host na USB, o console tem prioridade: a USB cairia
+            if (time_us_64() - entered_us >= POWER_DORMANT_MS * 1000ull && !stdio_usb_connected()) {
+                enter_dormant();
+                leave_idle();
+                last_activity_us = time_us_32();  // O toque que acordou conta como interação
+            }
+#endif
+            break;
+        default:
+            break;
+    }
+}
+
+power_state power_get_state(void) {
+    return state;
+}
+
+void power_get_stats(power_stats *out) {
+    *out = stats;
+    out->residency_us[state] += time_us_64() - entered_us;
+}
+
+// Imprime uma corrente em uA, ou "-" se não foi medida
+static void print_ua(const char *name, uint64_t ua) {
+    if (ua)
+        printf(" %s=%llu", name, (unsigned long long)ua);
+    else
+        printf(" %s=-", name);
+}
+
+// Relatório pela USB, uma linha por estado, uma para as saídas do ocioso e uma
+// para o consumo (- onde a corrente da placa não foi medida):
+//   P <estado> residency_ms=<t> entries=<n>
+//   P wakes=<n> wake_last_us=<t> wake_max_us=<m> dormant=<n>
+//   P current active_ua=<i|-> idle_ua=<i|-> avg_ua=<i|->
+void power_print_report(void) {
+    power_stats st;
+    power_get_stats(&st);
+
+    for (uint i = 0; i < POWER_NUM_STATES; i++)
+        printf("P %s residency_ms=%llu entries=%lu\n", state_names[i],
+               (unsigned long long)(st.residency_us[i] / 1000), (unsigned long)st.entries[i]);
+    printf("P wakes=%lu wake_last_us=%lu wake_max_us=%lu dormant=%lu\n", (unsigned long)st.wakes,
+           (unsigned long)st.wake_last_us, (unsigned long)st.wake_max_us, (unsigned long)st.dormant_count);
+
+    // Média ponderada pela residência, só com as duas correntes medidas
+    uint64_t total_us = st.residency_us[POWER_ACTIVE] + st.residency_us[POWER_IDLE];
+    uint64_t avg_ua = 0;
+    if (POWER_ACTIVE_UA && POWER_IDLE_UA && total_us)
+        avg_ua = (st.residency_us[POWER_ACTIVE] * POWER_ACTIVE_UA + st.residency_us[POWER_IDLE] * POWER_IDLE_UA) /
+                 total_us;
+    printf("P current");
+    print_ua("active_ua", POWER_ACTIVE_UA);
+    print_ua("idle_ua", POWER_IDLE_UA);
+    print_ua("avg_ua", avg_ua);
+    printf("\n");
+}
@@ -0,0 +1,57 @@
+#ifndef POWER_H_
+#define POWER_H_
+
+#include "pico/stdlib.h"
+
+// Economia de energia entre interações. Sem uso por POWER_BLANK_MS, o display
+// é apagado, o clk_sys cai para POWER_IDLE_SYS_KHZ e as entradas passam a ser
+// lidas a cada POWER_IDLE_POLL_MS (o núcleo dorme em WFE entre as leituras).
+// Uma borda de botão (por interrupção) ou o joystick fora do centro acordam o
+// quiosque. Com POWER_DORMANT, depois de mais POWER_DORMANT_MS ocioso e sem um
+// host na USB (a USB cairia), o cristal é parado e só uma borda de botão acorda.
+
+#ifndef POWER_DORMANT
+#define POWER_DORMANT 1
+#endif
+
+#define POWER_BLANK_MS 30000          // Sem interação até apagar o display
+#define POWER_IDLE_POLL_MS 50         // Leitura das entradas enquanto ocioso
+#define POWER_ACTIVE_SYS_KHZ 125000   // clk_sys padrão do SDK
+#define POWER_IDLE_SYS_KHZ 48000      // Múltiplo exato do cristal, PLL ainda travável
+#define POWER_DORMANT_MS 600000       // Ocioso até entrar em dormente
+
+// Corrente da placa em cada estado, em uA, para a estimativa de consumo médio
+// do relatório. Ainda não foram medidas (amperímetro em série com a entrada de
+// 5 V, em cada estado): 0 aparece como "-" no relatório até serem definidas.
+#ifndef POWER_ACTIVE_UA
+#define POWER_ACTIVE_UA 0
+#endif
+#ifndef POWER_IDLE_UA
+#define POWER_IDLE_UA 0
+#endif
+
+typedef enum {
+    POWER_ACTIVE,
+    POWER_IDLE,      // Display apagado, clock reduzido
+    POWER_NUM_STATES
+} power_state;
+
+typedef struct {
+    uint64_t residency_us[POWER_NUM_STATES];  // Tempo em cada estado, incluindo o atual
+    uint32_t entries[POWER_NUM_STATES];
+    uint32_t wakes;           // Saídas do ocioso por interação
+    uint32_t wake_last_us;    // Da borda (ou da leitura do joystick) até o quiosque ativo
+    uint32_t wake_max_us;
+    uint32_t dormant_count;   // Vezes em dormente (o timer para, sem residência)
+} power_stats;
+
+typedef void (*power_change_fn)(power_state from, power_state to);
+
+extern void power_init(const uint *wake_pins, uint count, power_change_fn on_change);
+extern void power_activity(uint32_t event_us);
+extern void power_poll(bool busy);
+extern power_state power_get_state(void);
+extern void power_get_stats(power_stats *stats);
+extern void power_print_report(void);
+
+#endif /* POWER_H_ */
@@ -0,0 +1,159 @@
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "scheduler.h"
+
+// Temporizador: o identificador combina o índice na tabela com uma geração,
+// para que cancelar um id antigo não afete um temporizador reutilizado
+typedef struct {
+    sched_fn fn;
+    void *arg;
+    uint64_t deadline_us;
+    uint32_t period_us;  // 0 = disparo único
+    uint8_t gen;
+    bool active;
+} sched_timer;
+
+typedef struct {
+    sched_fn fn;
+    void *arg;
+} sched_event;
+
+static sched_timer timers[SCHED_MAX_TIMERS];
+static sched_event queue[SCHED_QUEUE_LEN];
+static volatile uint32_t queue_head = 0;  // Próximo evento a executar
+static volatile uint32_t queue_tail = 0;  // Próxima posição livre
+
+static uint64_t default_clock(void) {
+    return time_us_64();
+}
+
+static void default_wait(uint64_t deadline_us) {
+    if (deadline_us == UINT64_MAX)
+        __wfe();
+    else
+        best_effort_wfe_or_timeout(from_us_since_boot(deadline_us));
+}
+
+static sched_clock_fn clock_fn = default_clock;
+static sched_wait_fn wait_fn = default_wait;
+
+// Sem relógio, volta ao do SDK; a espera acompanha o relógio, pois um prazo no
+// tempo virtual não tem sentido para o alarme do hardware
+void sched_set_clock(sched_clock_fn clock, sched_wait_fn wait) {
+    clock_fn = clock ? clock : default_clock;
+    wait_fn = clock ? wait : default_wait;
+}
+
+uint64_t sched_now_us(void) {
+    return clock_fn();
+}
+
+static sched_id add_timer(uint64_t delay_us, uint32_t period_us, sched_fn fn, void *arg) {
+    for (int i = 0; i < SCHED_MAX_TIMERS; i++) {
+        sched_timer *t = &timers[i];
+        if (t->active)
+            continue;
+        t->fn = fn;
+        t->arg = arg;
+        t->deadline_us = clock_fn() + delay_us;
+        t->period_us = period_us;
+        t->gen++;
+        t->active = true;
+        return (t->gen << 8) | i;
+    }
+    return -1;  // Tabela cheia
+}
+
+// Agenda fn para daqui a delay_ms, uma única vez
+sched_id sched_after_ms(uint32_t delay_ms, sched_fn fn, void *arg) {
+    return add_timer((uint64_t)delay_ms * 1000, 0, fn, arg);
+}
+
+// Agenda fn a cada period_ms, a primeira execução após um período
+sched_id sched_every_ms(uint32_t period_ms, sched_fn fn, void *arg) {
+    uint32_t period_us = period_ms * 1000;
+    return add_timer(period_us, period_us, fn, arg);
+}
+
+void sched_cancel(sched_id id) {
+    if (id < 0)
+        return;
+    int i = id & 0xFF;
+    if (i < SCHED_MAX_TIMERS && timers[i].gen == ((id >> 8) & 0xFF))
+        timers[i].active = false;
+}
+
+// Posta um evento para ser executado no próximo ciclo. Pode ser chamada de IRQs.
+bool sched_post(sched_fn fn, void *arg) {
+    uint32_t irq = save_and_disable_interrupts();
+    bool ok = (queue_tail - queue_head) < SCHED_QUEUE_LEN;
+    if (ok) {
+        queue[queue_tail % SCHED_QUEUE_LEN] = (sched_event){fn, arg};
+        queue_tail++;
+    }
+    restore_interrupts(irq);
+    __sev();  // Acorda o laço principal se estiver em WFE
+    return ok;
+}
+
+// Menor prazo entre os temporizadores ativos (UINT64_MAX se não houver nenhum)
+uint64_t sched_next_deadline_us(void) {
+    uint64_t next = UINT64_MAX;
+    for (int i = 0; i < SCHED_MAX_TIMERS; i++) {
+        if (timers[i].active && timers[i].deadline_us < next)
+            next = timers[i].deadline_us;
+    }
+    return next;
+}
+
+// Executa os eventos pendentes e os temporizadores vencidos.
+// Retorna true se alguma tarefa foi executada.
+bool sched_run_once(void) {
+    bool ran = false;
+
+    while (queue_head != queue_tail) {
+        sched_event ev = queue[queue_head % SCHED_QUEUE_LEN];
+        queue_head++;
+        ev.fn(ev.arg);
+        ran = true;
+    }
+
+    uint64_t now = clock_fn();
+    for (int i = 0; i < SCHED_MAX_TIMERS; i++) {
+        sched_timer *t = &timers[i];
+        if (!t->active || t->deadline_us > now)
+            continue;
+
+        if (t->period_us) {
+            t->deadline_us += t->period_us;
+            if (t->deadline_us <= now)  // Atrasou mais de um período: não acumula disparos
+                t->deadline_us = now + t->period_us;
+        } else {
+            t->active = false;
+        }
+        t->fn(t->arg);
+        ran = true;
+    }
+    return ran;
+}
+
+// Executa tarefas e dorme até o próximo prazo ou interrupção, até o relógio
+// chegar a until_us (UINT64_MAX: para sempre); o que vence em until_us executa
+void sched_run_until(uint64_t until_us) {
+    while (true) {
+        bool ran = sched_run_once();
+
+        if (clock_fn() >= until_us)
+            return;
+        if (ran || queue_head != queue_tail)
+            continue;
+
+        uint64_t next = sched_next_deadline_us();
+        wait_fn(next < until_us ? next : until_us);
+    }
+}
+
+// Laço principal
+void sched_run(void) {
+    sched_run_until(UINT64_MAX);
+}
@@ -0,0 +1,37 @@
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include "pico/stdlib.h"
+
+// Escalonador cooperativo: tarefas curtas disparadas por temporizadores (únicos
+// ou periódicos) ou postadas numa fila de eventos, inclusive a partir de IRQs.
+// Nenhuma tarefa deve bloquear; entre eventos o núcleo dorme em WFE.
+
+#define SCHED_MAX_TIMERS 16  // Quantidade máxima de temporizadores ativos
+#define SCHED_QUEUE_LEN 16   // Tamanho da fila de eventos (potência de 2)
+
+typedef void (*sched_fn)(void *arg);
+typedef int sched_id;        // Identificador de temporizador, negativo em caso de erro
+
+// Fonte de tempo em microssegundos; o padrão é time_us_64(), mas um relógio
+// virtual pode ser instalado para execuções determinísticas. Junto com ele vem
+// a espera ociosa do laço: dorme até deadline_us, no tempo desse relógio, ou até
+// um evento (UINT64_MAX: sem prazo). O padrão é WFE com o alarme do SDK. Os
+// dois são instalados juntos; clock NULL restaura ambos.
+typedef uint64_t (*sched_clock_fn)(void);
+typedef void (*sched_wait_fn)(uint64_t deadline_us);
+
+extern void sched_set_clock(sched_clock_fn clock, sched_wait_fn wait);
+extern uint64_t sched_now_us(void);
+
+extern sched_id sched_after_ms(uint32_t delay_ms, sched_fn fn, void *arg);
+extern sched_id sched_every_ms(uint32_t period_ms, sched_fn fn, void *arg);
+extern void sched_cancel(sched_id id);
+extern bool sched_post(sched_fn fn, void *arg);
+
+extern uint64_t sched_next_deadline_us(void);
+extern bool sched_run_once(void);
+extern void sched_run_until(uint64_t until_us);
+extern void sched_run(void);
+
+#endif /* SCHEDULER_H_ */
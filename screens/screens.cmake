@@ -0,0 +1,29 @@
+# Screens: the fixed kiosk screens in screens/kiosk.txt are rasterized by
+# tools/screengen.py into whole frames in flash, window header included, so
+# render_frame() sends them straight from XIP. Link bitdoglab_screens to get
+# screens.h; the generated source is compiled with the consuming target.
+
+find_package(Python3 REQUIRED COMPONENTS Interpreter)
+
+set(BITDOGLAB_SCREENS_DIR ${CMAKE_CURRENT_LIST_DIR})
+set(BITDOGLAB_SCREENS_OUT ${CMAKE_CURRENT_BINARY_DIR}/screens)
+
+add_custom_command(
+  OUTPUT ${BITDOGLAB_SCREENS_OUT}/screens.c ${BITDOGLAB_SCREENS_OUT}/screens.h
+  COMMAND ${CMAKE_COMMAND} -E make_directory ${BITDOGLAB_SCREENS_OUT}
+  COMMAND ${Python3_EXECUTABLE} ${BITDOGLAB_SCREENS_DIR}/../tools/screengen.py
+          ${BITDOGLAB_SCREENS_DIR}/../fonts/bitdog8.txt ${BITDOGLAB_SCREENS_DIR}/kiosk.txt
+          ${BITDOGLAB_SCREENS_OUT}/screens.c ${BITDOGLAB_SCREENS_OUT}/screens.h
+  DEPENDS ${BITDOGLAB_SCREENS_DIR}/kiosk.txt ${BITDOGLAB_SCREENS_DIR}/../fonts/bitdog8.txt
+          ${BITDOGLAB_SCREENS_DIR}/../tools/screengen.py ${BITDOGLAB_SCREENS_DIR}/../tools/fontgen.py
+  VERBATIM
+)
+
+add_library(bitdoglab_screens INTERFACE)
+
+target_sources(bitdoglab_screens INTERFACE ${BITDOGLAB_SCREENS_OUT}/screens.c)
+
+target_include_directories(bitdoglab_screens INTERFACE
+  ${BITDOGLAB_SCREENS_OUT}
+  ${BITDOGLAB_SCREENS_DIR}/..
+)
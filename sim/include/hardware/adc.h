@@ -0,0 +1,27 @@
+#ifndef SIM_HARDWARE_ADC_H_
+#define SIM_HARDWARE_ADC_H_
+
+#include "pico/stdlib.h"
+
+typedef struct {
+    volatile uint32_t cs;
+    volatile uint32_t result;
+    volatile uint32_t fcs;
+    volatile uint32_t fifo;
+    volatile uint32_t div;
+} adc_hw_t;
+
+extern adc_hw_t sim_adc_hw;
+#define adc_hw (&sim_adc_hw)
+#define DREQ_ADC 36
+
+void adc_init(void);
+void adc_gpio_init(uint gpio);
+void adc_select_input(uint input);
+uint16_t adc_read(void);
+void adc_set_round_robin(uint input_mask);
+void adc_fifo_setup(bool en, bool dreq_en, uint16_t dreq_thresh, bool err_in_fifo, bool byte_shift);
+void adc_set_clkdiv(float clkdiv);
+void adc_run(bool run);
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef SIM_HARDWARE_CLOCKS_H_
+#define SIM_HARDWARE_CLOCKS_H_
+
+#include "pico/stdlib.h"
+
+#define KHZ 1000
+#define MHZ 1000000
+
+enum clock_index { clk_gpout0, clk_gpout1, clk_gpout2, clk_gpout3, clk_ref, clk_sys, clk_peri, clk_usb, clk_adc, clk_rtc };
+
+#define CLOCKS_CLK_REF_CTRL_SRC_VALUE_XOSC_CLKSRC 0x2u
+#define CLOCKS_CLK_SYS_CTRL_SRC_VALUE_CLK_REF 0x0u
+#define CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_XOSC_CLKSRC 0x4u
+
+/* only clk_sys is modelled: it sets the speed of the I2C buses */
+bool clock_configure(enum clock_index clk_index, uint32_t src, uint32_t auxsrc, uint32_t src_freq, uint32_t freq);
+void clock_stop(enum clock_index clk_index);
+void clocks_init(void);
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef SIM_HARDWARE_DMA_H_
+#define SIM_HARDWARE_DMA_H_
+
+#include "pico/stdlib.h"
+
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2 };
+
+typedef struct {
+    enum dma_channel_transfer_size size;
+    bool read_increment;
+    bool write_increment;
+    bool ring_write;
+    uint ring_bits;
+    uint dreq;
+    uint chain_to;
+} dma_channel_config;
+
+int dma_claim_unused_channel(bool required);
+void dma_channel_unclaim(uint channel);
+dma_channel_config dma_channel_get_default_config(uint channel);
+
+static inline void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size) { c->size = size; }
+static inline void channel_config_set_read_increment(dma_channel_config *c, bool incr) { c->read_increment = incr; }
+static inline void channel_config_set_write_increment(dma_channel_config *c, bool incr) { c->write_increment = incr; }
+static inline void channel_config_set_dreq(dma_channel_config *c, uint dreq) { c->dreq = dreq; }
+static inline void channel_config_set_chain_to(dma_channel_config *c, uint chan) { c->chain_to = chan; }
+static inline void channel_config_set_ring(dma_channel_config *c, bool write, uint size_bits)
+{
+    c->ring_write = write;
+    c->ring_bits = size_bits;
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger);
+void dma_channel_start(uint channel);
+bool dma_channel_is_busy(uint channel);
+void dma_channel_abort(uint channel);
+
+#endif
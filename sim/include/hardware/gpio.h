@@ -0,0 +1,6 @@
+#ifndef SIM_HARDWARE_GPIO_H_
+#define SIM_HARDWARE_GPIO_H_
+
+#include "pico/stdlib.h"
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef SIM_HARDWARE_PLL_H_
+#define SIM_HARDWARE_PLL_H_
+
+#include "pico/stdlib.h"
+
+typedef struct pll_inst pll_inst_t;
+typedef pll_inst_t *PLL;
+
+extern pll_inst_t sim_pll_sys, sim_pll_usb;
+#define pll_sys (&sim_pll_sys)
+#define pll_usb (&sim_pll_usb)
+
+void pll_deinit(PLL pll);
+
+#endif
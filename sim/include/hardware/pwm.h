@@ -0,0 +1,14 @@
+#ifndef SIM_HARDWARE_PWM_H_
+#define SIM_HARDWARE_PWM_H_
+
+#include "pico/stdlib.h"
+
+static inline uint pwm_gpio_to_slice_num(uint gpio) { return (gpio >> 1u) & 7u; }
+static inline uint pwm_gpio_to_channel(uint gpio) { return gpio & 1u; }
+
+void pwm_set_wrap(uint slice, uint16_t wrap);
+void pwm_set_clkdiv(uint slice, float div);
+void pwm_set_gpio_level(uint gpio, uint16_t level);
+void pwm_set_enabled(uint slice, bool enabled);
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef SIM_HARDWARE_XOSC_H_
+#define SIM_HARDWARE_XOSC_H_
+
+#include "pico/stdlib.h"
+
+/* returns at the first edge on a pin armed with gpio_set_dormant_irq_enabled */
+void xosc_dormant(void);
+
+#endif
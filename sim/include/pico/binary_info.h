@@ -0,0 +1 @@
+/* nothing to record on the host */
@@ -0,0 +1,9 @@
+#ifndef SIM_PICO_FLASH_H_
+#define SIM_PICO_FLASH_H_
+
+#include "pico/stdlib.h"
+
+int flash_safe_execute(void (*func)(void *), void *param, uint32_t enter_exit_timeout_ms);
+static inline bool flash_safe_execute_core_init(void) { return true; }
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef SIM_PICO_MULTICORE_H_
+#define SIM_PICO_MULTICORE_H_
+
+#include "pico/stdlib.h"
+
+/* the simulator runs a single core; build with DISPLAY_MULTICORE=0 */
+void multicore_launch_core1(void (*entry)(void));
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef SIM_PICO_STDIO_DRIVER_H_
+#define SIM_PICO_STDIO_DRIVER_H_
+
+#include "pico/stdio_usb.h"
+
+/* A stdio back end. out_chars writes the bytes as given: CR/LF translation is
+ * done by the stdio layer above it, not by the driver. */
+struct stdio_driver {
+    void (*out_chars)(const char *buf, int len);
+    void (*out_flush)(void);
+    int (*in_chars)(char *buf, int len);
+    stdio_driver_t *next;
+    bool last_ended_with_cr;
+    bool crlf_enabled;
+};
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef SIM_PICO_STDIO_USB_H_
+#define SIM_PICO_STDIO_USB_H_
+
+#include "pico/stdlib.h"
+
+typedef struct stdio_driver stdio_driver_t;
+
+/* the USB console; while disabled, getchar_timeout_us() sees no input */
+extern stdio_driver_t stdio_usb;
+
+void stdio_set_driver_enabled(stdio_driver_t *driver, bool enabled);
+
+/* a host has the port open; scripts plug and unplug it with "usb_host" */
+bool stdio_usb_connected(void);
+
+#endif
@@ -0,0 +1,100 @@
+/*
+ * Host implementation of the subset of the Pico SDK used by the BitDogLab
+ * firmware. Time is virtual: it only advances while the firmware sleeps or
+ * waits for an event, and the simulator delivers scripted GPIO edges, ADC
+ * values and alarms in timestamp order as it does so.
+ */
+#ifndef SIM_PICO_STDLIB_H_
+#define SIM_PICO_STDLIB_H_
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef unsigned int uint;
+
+#define PICO_ON_DEVICE 0
+
+#define _u(x) x##u
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+#ifndef MIN
+#define MIN(a, b) ((b) < (a) ? (b) : (a))
+#define MAX(a, b) ((a) < (b) ? (b) : (a))
+#endif
+#define __not_in_flash_func(f) f
+#define __time_critical_func(f) f
+
+#define PICO_OK 0
+#define PICO_ERROR_GENERIC -1
+#define PICO_ERROR_TIMEOUT -2
+
+/* gpio */
+enum gpio_function { GPIO_FUNC_SIO = 5, GPIO_FUNC_PWM = 4, GPIO_FUNC_I2C = 3, GPIO_FUNC_PIO0 = 6, GPIO_FUNC_NULL = 0x1f };
+#define GPIO_OUT 1
+#define GPIO_IN 0
+#define GPIO_IRQ_LEVEL_LOW 0x1u
+#define GPIO_IRQ_LEVEL_HIGH 0x2u
+#define GPIO_IRQ_EDGE_FALL 0x4u
+#define GPIO_IRQ_EDGE_RISE 0x8u
+#define NUM_BANK0_GPIOS 30
+
+typedef void (*gpio_irq_callback_t)(uint gpio, uint32_t event_mask);
+
+void gpio_init(uint gpio);
+void gpio_set_function(uint gpio, enum gpio_function fn);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_pull_up(uint gpio);
+void gpio_pull_down(uint gpio);
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
+void gpio_set_irq_enabled(uint gpio, uint32_t events, bool enabled);
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t events, bool enabled, gpio_irq_callback_t callback);
+void gpio_set_dormant_irq_enabled(uint gpio, uint32_t events, bool enabled);
+void gpio_acknowledge_irq(uint gpio, uint32_t events);
+
+/* time */
+typedef uint64_t absolute_time_t;
+typedef int32_t alarm_id_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void *user_data);
+
+#define at_the_end_of_time ((absolute_time_t)UINT64_MAX)
+
+uint64_t time_us_64(void);
+static inline uint32_t time_us_32(void) { return (uint32_t)time_us_64(); }
+static inline absolute_time_t get_absolute_time(void) { return time_us_64(); }
+static inline uint64_t to_us_since_boot(absolute_time_t t) { return t; }
+static inline uint32_t to_ms_since_boot(absolute_time_t t) { return (uint32_t)(t / 1000); }
+static inline absolute_time_t from_us_since_boot(uint64_t us) { return us; }
+static inline absolute_time_t make_timeout_time_ms(uint32_t ms) { return time_us_64() + (uint64_t)ms * 1000; }
+static inline absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us) { return t + us; }
+
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+bool best_effort_wfe_or_timeout(absolute_time_t timeout);
+void __wfe(void);
+void __wfi(void);
+void __sev(void);
+static inline void __dmb(void) {}
+static inline void tight_loop_contents(void) {}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past);
+static inline alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data, bool fire_if_past)
+{
+    return add_alarm_in_us((uint64_t)ms * 1000, callback, user_data, fire_if_past);
+}
+bool cancel_alarm(alarm_id_t id);
+
+/* stdio */
+bool stdio_init_all(void);
+bool set_sys_clock_khz(uint32_t freq_khz, bool required);
+int getchar_timeout_us(uint32_t timeout_us);
+
+/* interrupts are never concurrent with the firmware in the simulator */
+static inline uint32_t save_and_disable_interrupts(void) { return 0; }
+static inline void restore_interrupts(uint32_t status) { (void)status; }
+
+uint get_core_num(void);  // Core 1 exists once launched, see multicore_launch_core1
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef SIM_PICO_UTIL_QUEUE_H_
+#define SIM_PICO_UTIL_QUEUE_H_
+
+#include "pico/stdlib.h"
+
+typedef struct {
+    uint8_t *data;
+    uint element_size;
+    uint element_count;
+    uint head, tail, level;
+} queue_t;
+
+void queue_init(queue_t *q, uint element_size, uint element_count);
+bool queue_try_add(queue_t *q, const void *data);
+bool queue_try_remove(queue_t *q, void *data);
+static inline uint queue_get_level(queue_t *q) { return q->level; }
+static inline bool queue_is_empty(queue_t *q) { return q->level == 0; }
+
+#endif
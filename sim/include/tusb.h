@@ -0,0 +1,13 @@
+#ifndef SIM_TUSB_H_
+#define SIM_TUSB_H_
+
+#include "pico/stdlib.h"
+
+/* CDC device side of TinyUSB: a host that is always connected and reads at the
+ * full speed bulk rate. What the firmware writes goes to BITDOGLAB_SIM_USB_OUT. */
+bool tud_cdc_connected(void);
+uint32_t tud_cdc_write_available(void);
+uint32_t tud_cdc_write(const void *buffer, uint32_t bufsize);
+uint32_t tud_cdc_write_flush(void);
+
+#endif
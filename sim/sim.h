@@ -0,0 +1,64 @@
+/*
+ * Internal interface of the host simulator: the virtual SSD1306 on the I2C
+ * bus, bus statistics and the trace output shared by the simulated peripherals.
+ */
+#ifndef SIM_H_
+#define SIM_H_
+
+#include "pico/stdlib.h"
+
+// Virtual SSD1306 panels: fed one I2C transaction at a time. The main panel,
+// the first attached, is the one dumped as frame_NNNNN.pbm.
+bool ssd1306_sim_attach(uint bus, uint8_t addr);
+bool ssd1306_sim_begin(uint bus, uint8_t addr);
+void ssd1306_sim_byte(uint8_t b);
+void ssd1306_sim_end(void);
+void ssd1306_sim_set_frame_dir(const char *dir);
+uint32_t ssd1306_sim_frames(void);
+bool ssd1306_sim_dump(const char *path);  // Main panel
+const uint8_t *ssd1306_sim_page(uint bus, uint8_t addr, uint page);  // Display RAM, NULL if no panel
+
+// Traffic seen on the simulated I2C buses since start (or the last reset)
+typedef struct {
+    uint64_t transactions;
+    uint64_t bytes;
+    uint64_t bus_time_us;  // Time the transfers would take at the configured baud rate
+} sim_i2c_stats;
+
+void sim_i2c_get_stats(sim_i2c_stats *stats);
+void sim_i2c_reset_stats(void);
+
+// Bus faults and timing, for the tests. The panels NAK their address above
+// max_khz (0: no limit). DMA flushes land the moment they start unless timed,
+// when the channel stays busy for the bus time; the next `count` ones stall
+// with the channel busy until the controller is told to abort.
+void sim_i2c_set_max_khz(uint khz);
+void sim_i2c_dma_timed(bool timed);
+void sim_i2c_stall_next(uint count);
+
+// Timestamped trace line on stdout; can be turned off by tools that own stdout
+void sim_set_trace(bool enabled);
+void sim_trace(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+// The RAM-backed flash (sim_flash[], what XIP reads see): operation counters,
+// erases per sector, and a power cut during the next program, which then gets
+// only its first `bytes` through
+typedef struct {
+    uint32_t erases;        // Sectors
+    uint32_t programs;      // flash_range_program calls
+    uint64_t program_bytes;
+} sim_flash_stats;
+
+void sim_flash_get_stats(sim_flash_stats *stats);
+void sim_flash_reset_stats(void);
+uint32_t sim_flash_sector_erases(uint32_t flash_offs);
+void sim_flash_tear_next_program(size_t bytes);
+void sim_flash_wipe(void);  // Back to all erased, as a new chip
+
+// Tests own the clock: ignore the end of run that would otherwise be scheduled
+void sim_keep_running(void);
+
+// Sets an input pin as a script "gpio" line would, raising its edge interrupt
+void sim_gpio_drive(uint gpio, bool level);
+
+#endif
@@ -0,0 +1,1144 @@
+/*
+ * Host backend of the Pico SDK subset used by the firmware: virtual clock,
+ * alarms, GPIO, PWM, ADC (with the DMA ring the joystick streams into), I2C
+ * (with the DMA path used for display flushes), a RAM-backed flash and core 1
+ * as a coroutine of core 0.
+ *
+ * Configuration comes from the environment:
+ *   BITDOGLAB_SIM_SCRIPT       input script (see sim/scripts/presence.txt)
+ *   BITDOGLAB_SIM_FRAMES       directory for frame_NNNNN.pbm dumps
+ *   BITDOGLAB_SIM_PANELS       panels on the buses as bus:addr[,bus:addr...] in
+ *                              hex, main panel first (default 1:3c)
+ *   BITDOGLAB_SIM_FLASH        file the simulated flash is loaded from/saved to
+ *   BITDOGLAB_SIM_DURATION_MS  virtual run time when the script has no "quit"
+ *   BITDOGLAB_SIM_I2C_MAX_KHZ  fastest bus clock the panels still ACK (no limit)
+ *   BITDOGLAB_SIM_USB_OUT      file the binary written to the USB CDC port goes to
+ */
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "pico/util/queue.h"
+#include "pico/flash.h"
+#include "hardware/adc.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/flash.h"
+#include "hardware/i2c.h"
+#include "hardware/pll.h"
+#include "hardware/pwm.h"
+#include "hardware/xosc.h"
+#include "pico/stdio_usb.h"
+#include "pico/stdio/driver.h"
+#include "tusb.h"
+#include "sim.h"
+
+#define SIM_SSD1306_ADDR 0x3C
+#define SIM_MAX_ALARMS 32
+#define SIM_DMA_CHANNELS 12
+#define SIM_ADC_INPUTS 5
+#define SIM_USB_TX_FIFO 4096      // CFG_TUD_CDC_TX_BUFSIZE of the firmware
+#define SIM_USB_BYTES_PER_MS 1216 // Full speed bulk: 19 packets of 64 bytes per frame
+#define SIM_CORE1_STACK (256 * 1024)
+#define SIM_PWM_SYS_KHZ 125000    // clk_sys the NOTE_* wraps of notes.h are computed for
+
+static uint64_t now_us = 0;
+
+// Core 1, a coroutine run while core 0 waits (see "multicore, queue")
+static uint current_core = 0;
+static void run_core1(void);
+static bool take_event(uint core);
+static uint64_t core1_deadline(void);
+static void core1_wait(uint64_t until, bool on_event);
+
+// Characters typed on the USB console by the script, not yet read
+static uint8_t usb_in[256];
+static uint32_t usb_in_head = 0, usb_in_tail = 0;
+static uint i2c_max_baud = 0;  // Above this the panels stop answering; 0 means no limit
+static bool i2c_dma_timed = false; // DMA flushes take their bus time instead of landing at once
+static uint i2c_stalls = 0;        // DMA flushes still to hang until the controller aborts
+static uint32_t sys_khz = 125000;  // clk_sys
+static bool usb_stdio_on = true;
+static bool usb_host = true;        // A host has the port open
+static bool dormant = false;        // Crystal stopped, waiting for a wake edge
+static FILE *usb_out = NULL;
+static uint32_t usb_fifo;           // Bytes written and not yet taken by the host
+static uint64_t usb_drained_us;
+static uint64_t usb_tx_bytes;
+static bool usb_in_driver = false;  // Inside stdio_usb.out_chars, which holds stdio_usb_mutex
+
+/* ---------------------------------------------------------------- trace */
+
+static bool trace_enabled = true;
+
+void sim_set_trace(bool enabled) {
+    trace_enabled = enabled;
+}
+
+void sim_trace(const char *fmt, ...) {
+    va_list ap;
+
+    if (!trace_enabled)
+        return;
+    printf("[%10.3f] ", now_us / 1000.0);
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+    putchar('\n');
+}
+
+/* --------------------------------------------------------------- script */
+
+typedef enum { EV_GPIO, EV_ADC, EV_I2C_MAX, EV_USB, EV_USB_HOST, EV_QUIT } script_kind;
+
+typedef struct {
+    uint64_t at_us;
+    script_kind kind;
+    uint a, b;
+} script_event;
+
+static script_event *script = NULL;
+static size_t script_len = 0, script_pos = 0;
+static bool keep_running = false;
+static void run_script_event(const script_event *ev);
+
+void sim_keep_running(void) {
+    keep_running = true;
+}
+
+static void script_push(uint64_t at_us, script_kind kind, uint a, uint b) {
+    script = realloc(script, (script_len + 1) * sizeof(*script));
+    script[script_len++] = (script_event){at_us, kind, a, b};
+}
+
+static void script_push_text(uint64_t at_us, const char *text) {
+    for (size_t i = 0; text[i]; i++)
+        script_push(at_us + i * 1000, EV_USB, (uint8_t)text[i], 0);
+}
+
+// One event per line, times in ms and non-decreasing:
+//   <ms> gpio <pin> <level>     drive an input pin (buttons are active low)
+//   <ms> adc <input> <value>    set the 12 bit value an ADC input converts to
+//   <ms> i2c_max <khz>          fastest bus clock the panels ACK from now on (0: no limit)
+//   <ms> usb <text>             type text on the USB console, one character per ms
+//   <ms> usb_host <0|1>         unplug or plug the USB host (plugged at start)
+//   <ms> quit                   end the simulation
+static void load_script(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "sim: cannot open script %s\n", path);
+        exit(2);
+    }
+
+    char line[256];
+    int lineno = 0;
+    while (fgets(line, sizeof(line), f)) {
+        char what[16];
+        unsigned long long ms;
+        uint a = 0, b = 0;
+
+        lineno++;
+        char *hash = strchr(line, '#');
+        if (hash)
+            *hash = '\0';
+        char text[64];
+        int n = sscanf(line, "%llu %15s %u %u", &ms, what, &a, &b);
+        if (n <= 0)
+            continue;
+        if (n >= 2 && !strcmp(what, "usb") && sscanf(line, "%*u %*s %63s", text) == 1)
+            script_push_text(ms * 1000, text);
+        else if (n >= 4 && !strcmp(what, "gpio"))
+            script_push(ms * 1000, EV_GPIO, a, b);
+        else if (n >= 4 && !strcmp(what, "adc"))
+            script_push(ms * 1000, EV_ADC, a, b);
+        else if (n >= 3 && !strcmp(what, "i2c_max"))
+            script_push(ms * 1000, EV_I2C_MAX, a, 0);
+        else if (n >= 3 && !strcmp(what, "usb_host"))
+            script_push(ms * 1000, EV_USB_HOST, a, 0);
+        else if (n >= 2 && !strcmp(what, "quit"))
+            script_push(ms * 1000, EV_QUIT, 0, 0);
+        else {
+            fprintf(stderr, "sim: %s:%d: cannot parse '%s'\n", path, lineno, line);
+            exit(2);
+        }
+    }
+    fclose(f);
+}
+
+// Panels as "bus:addr" pairs in hex, e.g. "1:3c,0:3d"; the board's own display when unset
+static void load_panels(const char *spec) {
+    if (!spec) {
+        ssd1306_sim_attach(1, SIM_SSD1306_ADDR);
+        return;
+    }
+
+    while (*spec) {
+        unsigned bus, addr;
+        int used;
+        if (sscanf(spec, " %x:%x%n", &bus, &addr, &used) != 2 || bus > 1 || addr > 0x7F ||
+            !ssd1306_sim_attach(bus, addr)) {
+            fprintf(stderr, "sim: bad panel list at '%s'\n", spec);
+            exit(2);
+        }
+        spec += used;
+        if (*spec == ',')
+            spec++;
+    }
+}
+
+/* ---------------------------------------------------------------- flash */
+
+uint8_t sim_flash[PICO_FLASH_SIZE_BYTES];
+static const char *flash_path = NULL;
+static sim_flash_stats flash_stats;
+static uint16_t sector_erases[PICO_FLASH_SIZE_BYTES / FLASH_SECTOR_SIZE];
+static size_t flash_tear_at = SIZE_MAX;  // Bytes the next program gets through
+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+    assert(flash_offs % FLASH_SECTOR_SIZE == 0 && count % FLASH_SECTOR_SIZE == 0);
+    assert(flash_offs + count <= PICO_FLASH_SIZE_BYTES);
+    memset(sim_flash + flash_offs, 0xFF, count);
+    for (uint32_t s = flash_offs / FLASH_SECTOR_SIZE; s < (flash_offs + count) / FLASH_SECTOR_SIZE; s++)
+        sector_erases[s]++;
+    flash_stats.erases += count / FLASH_SECTOR_SIZE;
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count) {
+    assert(flash_offs % FLASH_PAGE_SIZE == 0 && count % FLASH_PAGE_SIZE == 0);
+    assert(flash_offs + count <= PICO_FLASH_SIZE_BYTES);
+    flash_stats.programs++;
+    flash_stats.program_bytes += count;
+
+    // Power lost part way through: only the first bytes make it
+    if (flash_tear_at < count) {
+        sim_trace("FLASH program at 0x%06x torn after %zu bytes", flash_offs, flash_tear_at);
+        count = flash_tear_at;
+    }
+    flash_tear_at = SIZE_MAX;
+
+    // NOR flash: programming can only clear bits
+    for (size_t i = 0; i < count; i++)
+        sim_flash[flash_offs + i] &= data[i];
+}
+
+void sim_flash_get_stats(sim_flash_stats *stats) {
+    *stats = flash_stats;
+}
+
+void sim_flash_reset_stats(void) {
+    memset(&flash_stats, 0, sizeof(flash_stats));
+    memset(sector_erases, 0, sizeof(sector_erases));
+}
+
+uint32_t sim_flash_sector_erases(uint32_t flash_offs) {
+    return sector_erases[flash_offs / FLASH_SECTOR_SIZE];
+}
+
+void sim_flash_tear_next_program(size_t bytes) {
+    flash_tear_at = bytes;
+}
+
+void sim_flash_wipe(void) {
+    memset(sim_flash, 0xFF, sizeof(sim_flash));
+}
+
+int flash_safe_execute(void (*func)(void *), void *param, uint32_t enter_exit_timeout_ms) {
+    func(param);
+    return PICO_OK;
+}
+
+/* ----------------------------------------------------------------- setup */
+
+static bool stats_printed = false;
+
+static void sim_finish(void) {
+    if (stats_printed)
+        return;
+    stats_printed = true;
+
+    sim_i2c_stats s;
+    sim_i2c_get_stats(&s);
+    sim_trace("SUMMARY frames=%u i2c_transactions=%llu i2c_bytes=%llu i2c_bus_time_us=%llu",
+              ssd1306_sim_frames(), (unsigned long long)s.transactions,
+              (unsigned long long)s.bytes, (unsigned long long)s.bus_time_us);
+    if (usb_tx_bytes)
+        sim_trace("SUMMARY usb_tx_bytes=%llu", (unsigned long long)usb_tx_bytes);
+    if (usb_out)
+        fclose(usb_out);
+    usb_out = NULL;
+
+    if (flash_path) {
+        FILE *f = fopen(flash_path, "wb");
+        if (f) {
+            fwrite(sim_flash, 1, sizeof(sim_flash), f);
+            fclose(f);
+        }
+    }
+    fflush(stdout);
+}
+
+__attribute__((constructor)) static void sim_setup(void) {
+    const char *env;
+
+    memset(sim_flash, 0xFF, sizeof(sim_flash));
+    flash_path = getenv("BITDOGLAB_SIM_FLASH");
+    if (flash_path) {
+        FILE *f = fopen(flash_path, "rb");
+        if (f) {
+            if (fread(sim_flash, 1, sizeof(sim_flash), f) != sizeof(sim_flash))
+                fprintf(stderr, "sim: short flash image %s\n", flash_path);
+            fclose(f);
+        }
+    }
+
+    if ((env = getenv("BITDOGLAB_SIM_FRAMES")))
+        ssd1306_sim_set_frame_dir(env);
+
+    load_panels(getenv("BITDOGLAB_SIM_PANELS"));
+
+    if ((env = getenv("BITDOGLAB_SIM_I2C_MAX_KHZ")))
+        i2c_max_baud = strtoul(env, NULL, 10) * 1000;
+
+    if ((env = getenv("BITDOGLAB_SIM_SCRIPT")))
+        load_script(env);
+
+    if ((env = getenv("BITDOGLAB_SIM_USB_OUT")) && !(usb_out = fopen(env, "wb"))) {
+        fprintf(stderr, "sim: cannot create %s\n", env);
+        exit(2);
+    }
+
+    bool has_quit = false;
+    for (size_t i = 0; i < script_len; i++)
+        has_quit |= script[i].kind == EV_QUIT;
+    if (!has_quit) {
+        unsigned long long ms = 20000;
+        if ((env = getenv("BITDOGLAB_SIM_DURATION_MS")))
+            ms = strtoull(env, NULL, 10);
+        script_push(ms * 1000, EV_QUIT, 0, 0);
+    }
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    atexit(sim_finish);
+}
+
+bool stdio_init_all(void) {
+    return true;
+}
+
+int getchar_timeout_us(uint32_t timeout_us) {
+    if (!usb_stdio_on) {
+        sleep_us(timeout_us);
+        return PICO_ERROR_TIMEOUT;
+    }
+    if (usb_in_tail == usb_in_head)
+        sleep_us(timeout_us);
+    if (usb_in_tail == usb_in_head)
+        return PICO_ERROR_TIMEOUT;
+    return usb_in[usb_in_tail++ % sizeof(usb_in)];
+}
+
+/* ------------------------------------------------------------------ usb */
+
+static void usb_out_chars(const char *buf, int len);
+
+stdio_driver_t stdio_usb = {.out_chars = usb_out_chars, .crlf_enabled = true};
+
+void stdio_set_driver_enabled(stdio_driver_t *driver, bool enabled) {
+    if (driver == &stdio_usb && enabled != usb_stdio_on) {
+        sim_trace("USB stdio %s", enabled ? "on" : "off");
+        usb_stdio_on = enabled;
+    }
+}
+
+// The host takes bytes out of the CDC FIFO at the bus rate
+static void usb_drain(void) {
+    uint64_t taken = (now_us - usb_drained_us) * SIM_USB_BYTES_PER_MS / 1000;
+
+    if (taken) {
+        usb_fifo = taken >= usb_fifo ? 0 : usb_fifo - taken;
+        usb_drained_us = now_us;
+    }
+}
+
+bool stdio_usb_connected(void) {
+    return usb_host;
+}
+
+bool tud_cdc_connected(void) {
+    return usb_host;
+}
+
+uint32_t tud_cdc_write_available(void) {
+    usb_drain();
+    return SIM_USB_TX_FIFO - usb_fifo;
+}
+
+// On the device the stdio_usb IRQ runs tud_task() behind the firmware's back;
+// the CDC FIFO is only safe to touch with stdio_usb_mutex held, as the driver
+// does
+uint32_t tud_cdc_write(const void *buffer, uint32_t bufsize) {
+    uint32_t n = tud_cdc_write_available();
+
+    if (!usb_in_driver)
+        sim_trace("WARNING: tud_cdc_write outside stdio_usb_mutex");
+
+    if (n > bufsize)
+        n = bufsize;
+    if (usb_out)
+        fwrite(buffer, 1, n, usb_out);
+    usb_fifo += n;
+    usb_tx_bytes += n;
+    return n;
+}
+
+uint32_t tud_cdc_write_flush(void) {
+    return 0;
+}
+
+// stdio_usb_out_chars: with no room it waits PICO_STDIO_USB_STDOUT_TIMEOUT_US
+// for the host and then drops the rest, which a caller sizing its writes by
+// tud_cdc_write_available() never runs into
+static void usb_out_chars(const char *buf, int len) {
+    if (!usb_host)
+        return;
+    usb_in_driver = true;
+    uint32_t n = tud_cdc_write(buf, len);
+    usb_in_driver = false;
+    if (n < (uint32_t)len)
+        sim_trace("WARNING: USB stdout blocked, %u bytes dropped", (unsigned)(len - n));
+}
+
+/* ----------------------------------------------------------------- gpio */
+
+static struct {
+    bool out;
+    bool level;
+    uint32_t irq_events;
+    uint32_t dormant_events;  // Edges that wake the chip from dormant
+    enum gpio_function fn;
+} pins[NUM_BANK0_GPIOS];
+
+static gpio_irq_callback_t gpio_callback = NULL;
+
+void gpio_init(uint gpio) {
+    pins[gpio].out = false;
+    pins[gpio].level = false;
+    pins[gpio].fn = GPIO_FUNC_SIO;
+}
+
+void gpio_set_function(uint gpio, enum gpio_function fn) {
+    pins[gpio].fn = fn;
+}
+
+void gpio_set_dir(uint gpio, bool out) {
+    pins[gpio].out = out;
+}
+
+void gpio_pull_up(uint gpio) {
+    if (!pins[gpio].out)
+        pins[gpio].level = true;
+}
+
+void gpio_pull_down(uint gpio) {
+    if (!pins[gpio].out)
+        pins[gpio].level = false;
+}
+
+void gpio_put(uint gpio, bool value) {
+    if (pins[gpio].level != value)
+        sim_trace("GPIO %u %s", gpio, value ? "on" : "off");
+    pins[gpio].level = value;
+}
+
+bool gpio_get(uint gpio) {
+    return pins[gpio].level;
+}
+
+void gpio_set_irq_enabled(uint gpio, uint32_t events, bool enabled) {
+    if (enabled)
+        pins[gpio].irq_events |= events;
+    else
+        pins[gpio].irq_events &= ~events;
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t events, bool enabled, gpio_irq_callback_t callback) {
+    gpio_set_irq_enabled(gpio, events, enabled);
+    gpio_callback = callback;
+}
+
+void gpio_set_dormant_irq_enabled(uint gpio, uint32_t events, bool enabled) {
+    if (enabled)
+        pins[gpio].dormant_events |= events;
+    else
+        pins[gpio].dormant_events &= ~events;
+}
+
+void gpio_acknowledge_irq(uint gpio, uint32_t events) {
+}
+
+// While dormant nothing is clocked: an edge either wakes the chip or is lost,
+// and no interrupt reaches the firmware
+static void drive_input(uint gpio, bool level) {
+    if (gpio >= NUM_BANK0_GPIOS || pins[gpio].level == level)
+        return;
+    pins[gpio].level = level;
+
+    uint32_t edge = level ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+    if (dormant) {
+        if (pins[gpio].dormant_events & edge) {
+            sim_trace("WAKE gpio %u", gpio);
+            dormant = false;
+        }
+        return;
+    }
+    if (gpio_callback && (pins[gpio].irq_events & edge))
+        gpio_callback(gpio, edge);
+}
+
+void sim_gpio_drive(uint gpio, bool level) {
+    drive_input(gpio, level);
+}
+
+/* ------------------------------------------------------------------ pwm */
+
+static struct {
+    uint16_t wrap;
+    bool enabled;
+} slices[8];
+
+void pwm_set_wrap(uint slice, uint16_t wrap) {
+    slices[slice].wrap = wrap;
+}
+
+void pwm_set_clkdiv(uint slice, float div) {
+}
+
+void pwm_set_gpio_level(uint gpio, uint16_t level) {
+}
+
+// A tone started below the nominal clk_sys plays flat: the wrap counts cycles
+void pwm_set_enabled(uint slice, bool enabled) {
+    if (enabled)
+        sim_trace("PWM %u wrap %u", slice, slices[slice].wrap);
+    if (enabled && sys_khz != SIM_PWM_SYS_KHZ)
+        sim_trace("WARNING: PWM %u runs at clk_sys %u kHz", slice, sys_khz);
+    else if (slices[slice].enabled)
+        sim_trace("PWM %u off", slice);
+    slices[slice].enabled = enabled;
+}
+
+/* ------------------------------------------------------------------ adc */
+
+adc_hw_t sim_adc_hw;
+
+static uint16_t adc_value[SIM_ADC_INPUTS] = {2048, 2048, 2048, 2048, 876};
+static uint adc_input = 0;
+static uint adc_rr_mask = 0;
+static bool adc_running = false;
+
+void adc_init(void) {
+}
+
+void adc_gpio_init(uint gpio) {
+    gpio_set_function(gpio, GPIO_FUNC_NULL);
+}
+
+void adc_select_input(uint input) {
+    adc_input = input;
+}
+
+uint16_t adc_read(void) {
+    return adc_value[adc_input];
+}
+
+void adc_set_round_robin(uint input_mask) {
+    adc_rr_mask = input_mask;
+}
+
+void adc_fifo_setup(bool en, bool dreq_en, uint16_t dreq_thresh, bool err_in_fifo, bool byte_shift) {
+}
+
+void adc_set_clkdiv(float clkdiv) {
+}
+
+void adc_run(bool run) {
+    adc_running = run;
+}
+
+/* ------------------------------------------------------------------ i2c */
+
+i2c_inst_t sim_i2c0_inst = {.hw = {.status = I2C_IC_STATUS_TFE_BITS}, .index = 0};
+i2c_inst_t sim_i2c1_inst = {.hw = {.status = I2C_IC_STATUS_TFE_BITS}, .index = 1};
+
+static sim_i2c_stats i2c_stats;
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate) {
+    return i2c_set_baudrate(i2c, baudrate);
+}
+
+uint i2c_set_baudrate(i2c_inst_t *i2c, uint baudrate) {
+    i2c->baudrate = baudrate;
+    i2c->clk_khz = sys_khz;
+    return baudrate;
+}
+
+// Start + address byte, the payload, stop: 9 clocks per byte plus ~2 for start/stop.
+// The SCL dividers count clk_sys cycles, so changing clk_sys without setting the
+// baud rate again scales the bus speed. Returns the time the transaction takes
+// on the wire.
+static uint64_t transfer_us(i2c_inst_t *i2c, size_t len) {
+    uint baud = (uint64_t)(i2c->baudrate ? i2c->baudrate : 100000) * sys_khz /
+                (i2c->clk_khz ? i2c->clk_khz : 125000);
+
+    return ((len + 1) * 9 + 2) * 1000000ull / baud;
+}
+
+static uint64_t account(i2c_inst_t *i2c, size_t len) {
+    uint64_t us = transfer_us(i2c, len);
+
+    i2c_stats.transactions++;
+    i2c_stats.bytes += len + 1;
+    i2c_stats.bus_time_us += us;
+    return us;
+}
+
+// Starts a transaction on the panel at addr, false if the address is NAKed
+static bool address_acked(i2c_inst_t *i2c, uint8_t addr) {
+    if (i2c_max_baud && i2c->baudrate > i2c_max_baud) {
+        sim_trace("I2C%u NAK from 0x%02x at %u kHz", i2c->index, addr, i2c->baudrate / 1000);
+        return false;
+    }
+    return ssd1306_sim_begin(i2c->index, addr);
+}
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop) {
+    account(i2c, len);
+    if (!address_acked(i2c, addr))
+        return PICO_ERROR_GENERIC;  // Nobody answers: NAK on the address
+
+    for (size_t i = 0; i < len; i++)
+        ssd1306_sim_byte(src[i]);
+    ssd1306_sim_end();
+    return len;
+}
+
+// Transfers take no virtual time, but one that would outlast the deadline on
+// the wire times out, and nothing reaches the panel
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop,
+                         uint timeout_us) {
+    uint64_t us = transfer_us(i2c, len);
+
+    if (us > timeout_us) {
+        account(i2c, len);
+        sim_trace("I2C%u timeout to 0x%02x: %llu us on the wire, %u us allowed", i2c->index, addr,
+                  (unsigned long long)us, timeout_us);
+        return PICO_ERROR_TIMEOUT;
+    }
+    return i2c_write_blocking(i2c, addr, src, len, nostop);
+}
+
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop) {
+    account(i2c, len);
+    return PICO_ERROR_GENERIC;  // The SSD1306 in I2C mode cannot be read
+}
+
+void sim_i2c_get_stats(sim_i2c_stats *stats) {
+    *stats = i2c_stats;
+}
+
+void sim_i2c_reset_stats(void) {
+    memset(&i2c_stats, 0, sizeof(i2c_stats));
+}
+
+void sim_i2c_set_max_khz(uint khz) {
+    i2c_max_baud = khz * 1000;
+}
+
+void sim_i2c_dma_timed(bool timed) {
+    i2c_dma_timed = timed;
+}
+
+void sim_i2c_stall_next(uint count) {
+    i2c_stalls = count;
+}
+
+/* ------------------------------------------------------------------ dma */
+
+static struct {
+    bool claimed;
+    bool busy;
+    dma_channel_config cfg;
+    volatile void *write;
+    const volatile void *read;
+    uint count;
+    i2c_inst_t *i2c;   // Feeding this controller's TX FIFO
+    uint64_t done_us;  // When the transfer to it ends; UINT64_MAX while stalled
+} dma[SIM_DMA_CHANNELS];
+
+int dma_claim_unused_channel(bool required) {
+    for (int i = 0; i < SIM_DMA_CHANNELS; i++) {
+        if (!dma[i].claimed) {
+            dma[i].claimed = true;
+            return i;
+        }
+    }
+    if (required) {
+        fprintf(stderr, "sim: no DMA channel available\n");
+        abort();
+    }
+    return -1;
+}
+
+void dma_channel_unclaim(uint channel) {
+    dma[channel].claimed = false;
+}
+
+dma_channel_config dma_channel_get_default_config(uint channel) {
+    return (dma_channel_config){.size = DMA_SIZE_32, .read_increment = true, .chain_to = channel};
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger) {
+    dma[channel].cfg = *config;
+    dma[channel].write = write_addr;
+    dma[channel].read = read_addr;
+    dma[channel].count = transfer_count;
+    if (trigger)
+        dma_channel_start(channel);
+}
+
+// A transfer into an I2C TX FIFO: each word is a data byte, and the STOP flag
+// closes the transaction. The panel sees the data at once; the channel stays
+// busy for the bus time when timed, or until the controller is told to abort
+// when the transfer was set to stall.
+static void dma_to_i2c(uint channel, i2c_inst_t *i2c) {
+    const volatile uint8_t *src = dma[channel].read;
+    uint step = 1u << dma[channel].cfg.size;
+    size_t len = 0;
+    uint64_t bus_us = 0;
+
+    // reading clr_tx_abrt cannot be seen here, so each transfer starts clean
+    i2c->hw.raw_intr_stat &= ~I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS;
+    dma[channel].i2c = i2c;
+    if (i2c_stalls) {
+        i2c_stalls--;
+        sim_trace("I2C%u DMA transfer stalls", i2c->index);
+        dma[channel].busy = true;
+        dma[channel].done_us = UINT64_MAX;
+        return;
+    }
+    if (!address_acked(i2c, i2c->hw.tar)) {
+        i2c->hw.raw_intr_stat |= I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS;
+        return;
+    }
+
+    for (uint i = 0; i < dma[channel].count; i++) {
+        uint32_t word = step == 2 ? *(const volatile uint16_t *)(src + i * step)
+                                  : step == 4 ? *(const volatile uint32_t *)(src + i * step) : src[i];
+        ssd1306_sim_byte(word & 0xFF);
+        len++;
+        if (word & I2C_IC_DATA_CMD_STOP_BITS) {
+            ssd1306_sim_end();
+            bus_us += account(i2c, len);
+            len = 0;
+            ssd1306_sim_begin(i2c->index, i2c->hw.tar);
+        }
+    }
+    if (i2c_dma_timed) {
+        dma[channel].busy = true;
+        dma[channel].done_us = now_us + bus_us;
+    }
+}
+
+// IC_ENABLE.ABORT on a controller with a DMA transfer in flight: the transfer
+// ends and TX_ABRT is raised, as when the controller gives up on a stuck bus
+static void i2c_service(void) {
+    for (int ch = 0; ch < SIM_DMA_CHANNELS; ch++) {
+        i2c_inst_t *i2c = dma[ch].i2c;
+
+        if (!i2c || !(i2c->hw.enable & I2C_IC_ENABLE_ABORT_BITS))
+            continue;
+        i2c->hw.enable &= ~I2C_IC_ENABLE_ABORT_BITS;
+        if (dma[ch].busy) {
+            sim_trace("I2C%u transfer aborted", i2c->index);
+            dma[ch].busy = false;
+            i2c->hw.raw_intr_stat |= I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS;
+        }
+    }
+}
+
+void dma_channel_start(uint channel) {
+    dma[channel].i2c = NULL;
+    if (dma[channel].write == &sim_i2c0_inst.hw.data_cmd)
+        dma_to_i2c(channel, i2c0);
+    else if (dma[channel].write == &sim_i2c1_inst.hw.data_cmd)
+        dma_to_i2c(channel, i2c1);
+    else if (dma[channel].read == &sim_adc_hw.fifo)
+        dma[channel].busy = true;  // Paced by the ADC, filled as time advances
+}
+
+// Polling a transfer to I2C costs a microsecond, so a caller that spins on it
+// sees time pass and the transfer end (or its deadline go by)
+bool dma_channel_is_busy(uint channel) {
+    bool busy = dma[channel].busy;
+
+    if (busy && dma[channel].i2c) {
+        if (now_us >= dma[channel].done_us)
+            busy = dma[channel].busy = false;
+        else
+            sleep_us(1);
+    }
+    return busy;
+}
+
+void dma_channel_abort(uint channel) {
+    dma[channel].busy = false;
+}
+
+// The ADC ring channel always looks full of fresh round-robin samples
+static void adc_stream_fill(void) {
+    if (!adc_running)
+        return;
+
+    for (int ch = 0; ch < SIM_DMA_CHANNELS; ch++) {
+        if (!dma[ch].busy || dma[ch].read != &sim_adc_hw.fifo)
+            continue;
+
+        volatile uint16_t *dst = dma[ch].write;
+        uint len = dma[ch].cfg.ring_write ? (1u << dma[ch].cfg.ring_bits) / 2 : dma[ch].count;
+        uint input = 0;
+        for (uint i = 0; i < len; i++) {
+            while (adc_rr_mask && !(adc_rr_mask & (1u << input)))
+                input = (input + 1) % SIM_ADC_INPUTS;
+            dst[i] = adc_value[input];
+            input = (input + 1) % SIM_ADC_INPUTS;
+        }
+    }
+}
+
+/* --------------------------------------------------------------- clocks */
+
+// The PLL reaches any multiple of 1 MHz in the SDK's range; the rest is refused
+bool set_sys_clock_khz(uint32_t freq_khz, bool required) {
+    if (freq_khz % 1000 || freq_khz < 16000 || freq_khz > 133000) {
+        if (required) {
+            fprintf(stderr, "sim: clk_sys of %u kHz is not achievable\n", freq_khz);
+            abort();
+        }
+        return false;
+    }
+    if (freq_khz != sys_khz)
+        sim_trace("CLOCK sys %u kHz", freq_khz);
+    sys_khz = freq_khz;
+    return true;
+}
+
+bool clock_configure(enum clock_index clk_index, uint32_t src, uint32_t auxsrc, uint32_t src_freq, uint32_t freq) {
+    if (clk_index == clk_sys && freq / 1000 != sys_khz) {
+        sys_khz = freq / 1000;
+        sim_trace("CLOCK sys %u kHz", sys_khz);
+    }
+    return true;
+}
+
+void clock_stop(enum clock_index clk_index) {
+}
+
+// The boot configuration: clk_sys from the PLL at 125 MHz
+void clocks_init(void) {
+    if (sys_khz != 125000)
+        sim_trace("CLOCK sys 125000 kHz");
+    sys_khz = 125000;
+}
+
+struct pll_inst {
+    int unused;
+};
+pll_inst_t sim_pll_sys, sim_pll_usb;
+
+void pll_deinit(PLL pll) {
+}
+
+// Both cores stop until a wake edge. Script events keep coming at their times,
+// while alarms and core 1 wait: alarms due meanwhile fire late, on the way out,
+// as the stopped timer would make them.
+void xosc_dormant(void) {
+    sim_trace("DORMANT");
+    dormant = true;
+    while (dormant) {
+        if (script_pos == script_len) {
+            fprintf(stderr, "sim: dormant with no script event left to wake it\n");
+            sim_finish();
+            exit(1);
+        }
+        if (script[script_pos].at_us > now_us)
+            now_us = script[script_pos].at_us;
+        run_script_event(&script[script_pos++]);
+    }
+}
+
+/* ------------------------------------------------------- time and alarms */
+
+static struct {
+    alarm_id_t id;
+    uint64_t at_us;
+    alarm_callback_t callback;
+    void *user_data;
+} alarms[SIM_MAX_ALARMS];
+
+static alarm_id_t next_alarm_id = 1;
+
+uint64_t time_us_64(void) {
+    return now_us;
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    for (int i = 0; i < SIM_MAX_ALARMS; i++) {
+        if (alarms[i].id)
+            continue;
+        alarms[i].id = next_alarm_id++;
+        alarms[i].at_us = now_us + us;
+        alarms[i].callback = callback;
+        alarms[i].user_data = user_data;
+        return alarms[i].id;
+    }
+    return -1;
+}
+
+bool cancel_alarm(alarm_id_t id) {
+    for (int i = 0; i < SIM_MAX_ALARMS; i++) {
+        if (alarms[i].id == id && id) {
+            alarms[i].id = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+static int next_alarm(void) {
+    int best = -1;
+    for (int i = 0; i < SIM_MAX_ALARMS; i++) {
+        if (alarms[i].id && (best < 0 || alarms[i].at_us < alarms[best].at_us))
+            best = i;
+    }
+    return best;
+}
+
+static void fire_alarm(int i) {
+    alarm_id_t id = alarms[i].id;
+    int64_t ret = alarms[i].callback(id, alarms[i].user_data);
+
+    if (alarms[i].id != id)
+        return;  // Cancelled from inside the callback
+    if (ret > 0)
+        alarms[i].at_us += ret;
+    else if (ret < 0)
+        alarms[i].at_us = now_us - ret;
+    else
+        alarms[i].id = 0;
+}
+
+static void run_script_event(const script_event *ev) {
+    switch (ev->kind) {
+    case EV_GPIO:
+        sim_trace("INPUT gpio %u = %u", ev->a, ev->b);
+        drive_input(ev->a, ev->b);
+        break;
+    case EV_ADC:
+        sim_trace("INPUT adc %u = %u", ev->a, ev->b);
+        if (ev->a < SIM_ADC_INPUTS)
+            adc_value[ev->a] = ev->b;
+        break;
+    case EV_USB:
+        usb_in[usb_in_head++ % sizeof(usb_in)] = ev->a;
+        break;
+    case EV_I2C_MAX:
+        sim_trace("INPUT i2c_max %u kHz", ev->a);
+        i2c_max_baud = ev->a * 1000;
+        break;
+    case EV_USB_HOST:
+        sim_trace("INPUT usb_host %u", ev->a);
+        usb_host = ev->a;
+        break;
+    case EV_QUIT:
+        if (keep_running)
+            break;
+        sim_finish();
+        exit(0);
+    }
+}
+
+// Moves virtual time forward to `until`, delivering alarms and script events in
+// order. With wake_on_event, returns right after the first one, as an
+// interrupt would wake the core.
+static void sim_advance(uint64_t until, bool wake_on_event) {
+    for (;;) {
+        run_core1();
+        if (wake_on_event && take_event(0))
+            return;  // Core 1 signalled with SEV
+
+        int a = next_alarm();
+        uint64_t t_alarm = a >= 0 ? alarms[a].at_us : UINT64_MAX;
+        uint64_t t_script = script_pos < script_len ? script[script_pos].at_us : UINT64_MAX;
+        uint64_t t_core1 = core1_deadline();
+        uint64_t t = t_alarm < t_script ? t_alarm : t_script;
+
+        if (t_core1 < t && t_core1 <= until) {
+            now_us = t_core1 > now_us ? t_core1 : now_us;
+            continue;  // Core 1 wakes from its timeout, and runs on the next pass
+        }
+        if (t == UINT64_MAX || t > until)
+            break;
+        if (t > now_us)
+            now_us = t;
+        if (t_script <= t_alarm)
+            run_script_event(&script[script_pos++]);
+        else
+            fire_alarm(a);
+        adc_stream_fill();
+        i2c_service();
+        if (wake_on_event)
+            return;
+    }
+    if (until != UINT64_MAX && until > now_us)
+        now_us = until;
+    adc_stream_fill();
+    i2c_service();
+    run_core1();
+}
+
+void sleep_us(uint64_t us) {
+    if (current_core)
+        core1_wait(now_us + us, false);
+    else
+        sim_advance(now_us + us, false);
+}
+
+void sleep_ms(uint32_t ms) {
+    sleep_us((uint64_t)ms * 1000);
+}
+
+bool best_effort_wfe_or_timeout(absolute_time_t timeout) {
+    if (timeout <= now_us)
+        return true;
+    if (current_core)
+        core1_wait(timeout, true);
+    else
+        sim_advance(timeout, true);
+    return now_us >= timeout;
+}
+
+void __wfe(void) {
+    if (current_core)
+        core1_wait(UINT64_MAX, true);
+    else
+        sim_advance(UINT64_MAX, true);
+}
+
+void __wfi(void) {
+    __wfe();
+}
+
+/* ------------------------------------------------------ multicore, queue */
+
+// Core 1 is a coroutine: it runs whenever core 0 waits (in sim_advance), until
+// it waits itself, for a time or an event. Virtual time only moves while both
+// cores wait, and interrupts (alarms, GPIO, script input) are all taken on core
+// 0, where the firmware sets them up.
+static ucontext_t core_ctx[2];
+static void (*core1_entry)(void);
+static bool core1_launched = false;
+
+static struct {
+    bool event;      // Event register: set by SEV, cleared by the WFE it wakes
+    bool on_event;   // Waiting in WFE: an event wakes it too
+    uint64_t until;  // Waiting until this time; UINT64_MAX without timeout
+} core_wait[2];
+
+uint get_core_num(void) {
+    return current_core;
+}
+
+void __sev(void) {
+    core_wait[0].event = core_wait[1].event = true;
+}
+
+static bool take_event(uint core) {
+    bool event = core_wait[core].event;
+    core_wait[core].event = false;
+    return event;
+}
+
+static bool core1_runnable(void) {
+    return core1_launched && (now_us >= core_wait[1].until || (core_wait[1].on_event && core_wait[1].event));
+}
+
+// When core 1's wait times out, UINT64_MAX if it only waits for an event
+static uint64_t core1_deadline(void) {
+    return core1_launched && !core1_runnable() ? core_wait[1].until : UINT64_MAX;
+}
+
+static void run_core1(void) {
+    while (current_core == 0 && core1_runnable()) {
+        current_core = 1;
+        swapcontext(&core_ctx[0], &core_ctx[1]);
+        current_core = 0;
+    }
+}
+
+// Core 1 waits: back to core 0 until the time or (on_event) an event comes
+static void core1_wait(uint64_t until, bool on_event) {
+    if (on_event && take_event(1))
+        return;
+    core_wait[1].until = until;
+    core_wait[1].on_event = on_event;
+    swapcontext(&core_ctx[1], &core_ctx[0]);
+    if (on_event)
+        take_event(1);
+}
+
+static void core1_start(void) {
+    core1_entry();
+    core1_wait(UINT64_MAX, false);  // Returned: core 1 stays halted
+}
+
+void multicore_launch_core1(void (*entry)(void)) {
+    assert(!core1_launched);
+    getcontext(&core_ctx[1]);
+    core_ctx[1].uc_stack.ss_sp = malloc(SIM_CORE1_STACK);
+    core_ctx[1].uc_stack.ss_size = SIM_CORE1_STACK;
+    core_ctx[1].uc_link = NULL;
+    makecontext(&core_ctx[1], core1_start, 0);
+    core1_entry = entry;
+    core_wait[1].until = 0;  // Runs as soon as core 0 waits
+    core1_launched = true;
+}
+
+void queue_init(queue_t *q, uint element_size, uint element_count) {
+    q->data = calloc(element_count, element_size);
+    q->element_size = element_size;
+    q->element_count = element_count;
+    q->head = q->tail = q->level = 0;
+}
+
+bool queue_try_add(queue_t *q, const void *data) {
+    if (q->level == q->element_count)
+        return false;
+    memcpy(q->data + q->tail * q->element_size, data, q->element_size);
+    q->tail = (q->tail + 1) % q->element_count;
+    q->level++;
+    __sev();  // As the SDK queue does, to wake a core waiting on it
+    return true;
+}
+
+bool queue_try_remove(queue_t *q, void *data) {
+    if (q->level == 0)
+        return false;
+    memcpy(data, q->data + q->head * q->element_size, q->element_size);
+    q->head = (q->head + 1) % q->element_count;
+    q->level--;
+    __sev();
+    return true;
+}
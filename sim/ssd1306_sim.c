@@ -0,0 +1,275 @@
+/*
+ * Virtual SSD1306 panels. Each one sits at a bus and address, interprets the
+ * control bytes, commands and display data of the I2C transactions sent to it,
+ * keeps its own copy of the 128x64 display RAM and, when a frame directory is
+ * set, dumps the visible panel as a PBM after every transaction that wrote
+ * display data or moved the start line. The panel height follows the
+ * multiplex ratio the driver programs.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "sim.h"
+#include "ssd1306_i2c.h"
+
+#define RAM_PAGES 8
+#define FRAME_US 5700  // Panel refresh period with the clock set by SSD1306_init
+#define MAX_PANELS 4
+
+typedef struct {
+    uint bus;
+    uint8_t addr;
+    uint8_t height;  // Multiplex ratio + 1
+    uint8_t gddram[RAM_PAGES][SSD1306_WIDTH];
+
+    struct {
+        uint8_t col_start, col_end, page_start, page_end;
+        uint8_t col, page;
+        uint8_t start_line;
+        bool display_on;
+        bool inverted;
+    } st;
+
+    // Continuous horizontal scroll: the RAM rotation is applied when it stops
+    struct {
+        bool active;
+        bool left;
+        uint8_t page_start, page_end;
+        uint32_t frames_per_step;
+        uint64_t since_us;
+    } scroll;
+
+    // Command parser: opcode waiting for its parameters
+    uint8_t cmd_op;
+    uint8_t cmd_params[8];
+    int cmd_have, cmd_need;
+
+    uint32_t frame_count;
+} panel_t;
+
+static panel_t panels[MAX_PANELS];
+static int num_panels = 0;
+static panel_t *p;  // Addressed by the current transaction
+
+static const uint16_t scroll_frames[8] = {5, 64, 128, 256, 3, 4, 25, 2};
+
+// Transaction parser
+static enum { EXPECT_CONTROL, SINGLE_BYTE, STREAM } phase;
+static bool data_mode;     // D/C bit of the current control byte
+static bool wrote_data;    // this transaction touched display RAM
+static bool moved;         // or changed what part of it is visible
+
+static const char *frame_dir = NULL;
+static uint32_t frame_count = 0;
+
+static int param_count(uint8_t op) {
+    switch (op) {
+    case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+    case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+        return 1;
+    case 0x21: case 0x22: case 0xA3:
+        return 2;
+    case 0x29: case 0x2A:
+        return 5;
+    case 0x26: case 0x27:
+        return 6;
+    default:
+        return 0;
+    }
+}
+
+static void scroll_finish(void) {
+    uint32_t steps = (time_us_64() - p->scroll.since_us) / FRAME_US / p->scroll.frames_per_step;
+    int shift = steps % SSD1306_WIDTH;
+
+    for (int page = p->scroll.page_start; page <= p->scroll.page_end; page++) {
+        uint8_t row[SSD1306_WIDTH];
+        for (int x = 0; x < SSD1306_WIDTH; x++)
+            row[x] = p->gddram[page][(x + (p->scroll.left ? shift : SSD1306_WIDTH - shift)) % SSD1306_WIDTH];
+        memcpy(p->gddram[page], row, sizeof(row));
+    }
+    p->scroll.active = false;
+    sim_trace("SCROLL stop after %u steps", (unsigned)steps);
+}
+
+static void execute_command(void) {
+    switch (p->cmd_op) {
+    case 0x26:
+    case 0x27:
+        p->scroll.left = p->cmd_op == 0x27;
+        p->scroll.page_start = p->cmd_params[1] % RAM_PAGES;
+        p->scroll.frames_per_step = scroll_frames[p->cmd_params[2] & 7];
+        p->scroll.page_end = p->cmd_params[3] % RAM_PAGES;
+        break;
+    case 0x2E:
+        if (p->scroll.active)
+            scroll_finish();
+        break;
+    case 0x2F:
+        p->scroll.active = true;
+        p->scroll.since_us = time_us_64();
+        sim_trace("SCROLL pages %u-%u %s, a column every %u frames", p->scroll.page_start, p->scroll.page_end,
+                  p->scroll.left ? "left" : "right", (unsigned)p->scroll.frames_per_step);
+        break;
+    case 0x21:
+        p->st.col_start = p->cmd_params[0] % SSD1306_WIDTH;
+        p->st.col_end = p->cmd_params[1] % SSD1306_WIDTH;
+        p->st.col = p->st.col_start;
+        break;
+    case 0x22:
+        p->st.page_start = p->cmd_params[0] % RAM_PAGES;
+        p->st.page_end = p->cmd_params[1] % RAM_PAGES;
+        p->st.page = p->st.page_start;
+        break;
+    case 0xA8:
+        p->height = (p->cmd_params[0] & 0x3F) + 1;
+        break;
+    case 0xA6:
+    case 0xA7:
+        p->st.inverted = p->cmd_op == 0xA7;
+        break;
+    case 0xAE:
+    case 0xAF:
+        p->st.display_on = p->cmd_op == 0xAF;
+        break;
+    default:
+        if (p->cmd_op >= 0x40 && p->cmd_op <= 0x7F) {
+            moved |= p->st.start_line != (p->cmd_op & 0x3F);
+            p->st.start_line = p->cmd_op & 0x3F;
+        }
+        break;
+    }
+}
+
+static void command_byte(uint8_t b) {
+    if (p->cmd_need == 0) {
+        p->cmd_op = b;
+        p->cmd_have = 0;
+        p->cmd_need = param_count(b);
+    } else {
+        p->cmd_params[p->cmd_have++] = b;
+        p->cmd_need--;
+    }
+    if (p->cmd_need == 0)
+        execute_command();
+}
+
+static void data_byte(uint8_t b) {
+    // horizontal addressing: column wraps to the next page inside the window
+    if (p->scroll.active && p->st.page >= p->scroll.page_start && p->st.page <= p->scroll.page_end)
+        sim_trace("WARNING: RAM write to page %u while it scrolls", p->st.page);
+    p->gddram[p->st.page][p->st.col] = b;
+    wrote_data = true;
+    if (p->st.col++ >= p->st.col_end) {
+        p->st.col = p->st.col_start;
+        if (p->st.page++ >= p->st.page_end)
+            p->st.page = p->st.page_start;
+    }
+}
+
+// Adds a panel at bus:addr; the first one added is the main panel
+bool ssd1306_sim_attach(uint bus, uint8_t addr) {
+    if (num_panels == MAX_PANELS)
+        return false;
+
+    panel_t *n = &panels[num_panels++];
+    memset(n, 0, sizeof(*n));
+    n->bus = bus;
+    n->addr = addr;
+    n->height = SSD1306_HEIGHT;
+    n->st.col_end = SSD1306_WIDTH - 1;
+    n->st.page_end = RAM_PAGES - 1;
+    return true;
+}
+
+// Starts a transaction; false when no panel answers at bus:addr
+bool ssd1306_sim_begin(uint bus, uint8_t addr) {
+    p = NULL;
+    for (int i = 0; i < num_panels; i++)
+        if (panels[i].bus == bus && panels[i].addr == addr)
+            p = &panels[i];
+    if (!p)
+        return false;
+
+    phase = EXPECT_CONTROL;
+    wrote_data = false;
+    moved = false;
+    return true;
+}
+
+void ssd1306_sim_byte(uint8_t b) {
+    switch (phase) {
+    case EXPECT_CONTROL:
+        data_mode = b & 0x40;
+        phase = (b & 0x80) ? SINGLE_BYTE : STREAM;
+        break;
+    case SINGLE_BYTE:
+        data_mode ? data_byte(b) : command_byte(b);
+        phase = EXPECT_CONTROL;
+        break;
+    case STREAM:
+        data_mode ? data_byte(b) : command_byte(b);
+        break;
+    }
+}
+
+static bool dump_panel(const panel_t *panel, const char *path);
+
+void ssd1306_sim_end(void) {
+    if (!wrote_data && !moved)
+        return;
+    frame_count++;
+    p->frame_count++;
+    if (frame_dir) {
+        // the main panel keeps the plain names, the others are prefixed with bus and address
+        char path[512];
+        if (p == &panels[0])
+            snprintf(path, sizeof(path), "%s/frame_%05u.pbm", frame_dir, p->frame_count);
+        else
+            snprintf(path, sizeof(path), "%s/i2c%u_%02x_frame_%05u.pbm", frame_dir, p->bus, p->addr, p->frame_count);
+        dump_panel(p, path);
+    }
+    if (p == &panels[0])
+        sim_trace("FRAME %u", frame_count);
+    else
+        sim_trace("FRAME %u (i2c%u 0x%02x)", frame_count, p->bus, p->addr);
+}
+
+void ssd1306_sim_set_frame_dir(const char *dir) {
+    frame_dir = dir;
+}
+
+uint32_t ssd1306_sim_frames(void) {
+    return frame_count;
+}
+
+// Writes the visible panel (start line applied, lit pixels black) as a binary PBM
+static bool dump_panel(const panel_t *panel, const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (!f)
+        return false;
+
+    fprintf(f, "P4\n%d %d\n", SSD1306_WIDTH, panel->height);
+    for (int y = 0; y < panel->height; y++) {
+        int ram_y = (y + panel->st.start_line) % (RAM_PAGES * 8);
+        uint8_t row[SSD1306_WIDTH / 8] = {0};
+        for (int x = 0; x < SSD1306_WIDTH; x++) {
+            bool lit = (panel->gddram[ram_y / 8][x] >> (ram_y % 8)) & 1;
+            if (panel->st.display_on && (lit != panel->st.inverted))
+                row[x / 8] |= 0x80 >> (x % 8);
+        }
+        fwrite(row, 1, sizeof(row), f);
+    }
+    fclose(f);
+    return true;
+}
+
+bool ssd1306_sim_dump(const char *path) {
+    return num_panels && dump_panel(&panels[0], path);
+}
+
+const uint8_t *ssd1306_sim_page(uint bus, uint8_t addr, uint page) {
+    for (int i = 0; i < num_panels; i++)
+        if (panels[i].bus == bus && panels[i].addr == addr && page < RAM_PAGES)
+            return panels[i].gddram[page];
+    return NULL;
+}
@@ -0,0 +1,37 @@
+// Minimal checks for the host tests. A failed CHECK reports itself and the test
+// goes on; main returns CHECK_RESULT(), non-zero if anything failed.
+#ifndef SIM_TESTS_CHECK_H_
+#define SIM_TESTS_CHECK_H_
+
+#include <stdio.h>
+
+static int check_failures;
+
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            check_failures++;                                                        \
+        }                                                                            \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                                \
+    do {                                                                              \
+        long long a_ = (long long)(a), b_ = (long long)(b);                           \
+        if (a_ != b_) {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s == %s (%lld != %lld)\n",         \
+                    __FILE__, __LINE__, #a, #b, a_, b_);                              \
+            check_failures++;                                                         \
+        }                                                                             \
+    } while (0)
+
+#define RUN_TEST(fn)                                                             \
+    do {                                                                         \
+        int before_ = check_failures;                                            \
+        fn();                                                                    \
+        printf("%s %s\n", check_failures == before_ ? "ok  " : "FAIL", #fn);     \
+    } while (0)
+
+#define CHECK_RESULT() (check_failures ? 1 : 0)
+
+#endif /* SIM_TESTS_CHECK_H_ */
@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+"""Run the simulator on a script and check what it printed.
+
+Usage: run_script.py SIM SCRIPT [--compare SIM2] [--replay TOOL]
+
+Besides the input events, a script carries its own checks as comments:
+
+  # expect: REGEX         a later output line must match, in the order given
+  # reject: REGEX         no output line may match
+  # env: NAME=VALUE       extra environment for the run
+  # usb-records: N        the binary written to the USB port decodes
+                          (tools/attendance_export.py) to exactly N records
+
+With --compare, SIM2 runs the same script too and both must dump the same
+sequence of frames on the main panel. With --replay, the "F" transition lines
+the run printed are piped to TOOL (test_fsm), which must replay them.
+"""
+import argparse
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+sys.dont_write_bytecode = True
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..")
+sys.path.insert(0, os.path.join(ROOT, "tools"))
+import attendance_export  # noqa: E402
+
+DIRECTIVE = re.compile(r"#\s*(expect|reject|env|usb-records):\s*(.*?)\s*$")
+
+
+def parse(script):
+    checks = {"expect": [], "reject": [], "env": [], "usb-records": []}
+    with open(script, encoding="utf-8") as f:
+        for line in f:
+            m = DIRECTIVE.search(line)
+            if m:
+                checks[m.group(1)].append(m.group(2))
+    return checks
+
+
+def run(sim, script, env_extra, workdir):
+    frames = os.path.join(workdir, "frames")
+    os.makedirs(frames)
+    env = dict(os.environ)
+    env.update(BITDOGLAB_SIM_SCRIPT=script, BITDOGLAB_SIM_FRAMES=frames,
+               BITDOGLAB_SIM_USB_OUT=os.path.join(workdir, "usb.bin"))
+    for item in env_extra:
+        name, _, value = item.partition("=")
+        env[name] = value
+    out = subprocess.run([sim], env=env, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                         universal_newlines=True, timeout=300)
+    return out.returncode, out.stdout.splitlines(), frames
+
+
+def frame_list(frames):
+    names = sorted(n for n in os.listdir(frames) if n.startswith("frame_"))
+    result = []
+    for n in names:
+        with open(os.path.join(frames, n), "rb") as f:
+            result.append(f.read())
+    return result
+
+
+def usb_records(path):
+    with open(path, "rb") as f:
+        stream = attendance_export.Stream(f.fileno(), False)
+        count = 0
+        for kind, _, payload, ok in attendance_export.frames(stream):
+            if not ok:
+                return -1
+            count += sum(1 for _ in attendance_export.records(payload))
+            if kind == attendance_export.END:
+                break
+    return count
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("sim")
+    ap.add_argument("script")
+    ap.add_argument("--compare")
+    ap.add_argument("--replay")
+    args = ap.parse_args()
+
+    checks = parse(args.script)
+    failures = []
+    with tempfile.TemporaryDirectory() as tmp:
+        code, lines, frames = run(args.sim, args.script, checks["env"], os.path.join(tmp, "a"))
+        if code:
+            failures.append(f"simulator exited with {code}")
+
+        pos = 0
+        for pattern in checks["expect"]:
+            rx = re.compile(pattern)
+            while pos < len(lines) and not rx.search(lines[pos]):
+                pos += 1
+            if pos == len(lines):
+                failures.append(f"expected, in order: {pattern}")
+                break
+            pos += 1
+
+        for pattern in checks["reject"]:
+            rx = re.compile(pattern)
+            hits = [l for l in lines if rx.search(l)]
+            if hits:
+                failures.append(f"rejected pattern {pattern} matched: {hits[0]}")
+
+        for want in checks["usb-records"]:
+            got = usb_records(os.path.join(tmp, "a", "usb.bin"))
+            if got != int(want):
+                failures.append(f"USB export decoded to {got} records, expected {want}")
+
+        if args.replay:
+            trace = "".join(l + "\n" for l in lines if l.startswith("F "))
+            if not trace:
+                failures.append("no transitions to replay (tracing off?)")
+            out = subprocess.run([args.replay, "-"], input=trace, stdout=subprocess.PIPE,
+                                 stderr=subprocess.STDOUT, universal_newlines=True, timeout=60)
+            if out.returncode:
+                failures.append(f"replay failed: {out.stdout.strip()}")
+
+        if args.compare:
+            code2, _, frames2 = run(args.compare, args.script, checks["env"], os.path.join(tmp, "b"))
+            if code2:
+                failures.append(f"{args.compare} exited with {code2}")
+            a, b = frame_list(frames), frame_list(frames2)
+            if a != b:
+                first = next((i for i, (x, y) in enumerate(zip(a, b)) if x != y), min(len(a), len(b)))
+                failures.append(f"frames differ from {os.path.basename(args.compare)}: "
+                                f"{len(a)} vs {len(b)} frames, first difference at frame {first + 1}")
+
+    if failures:
+        sys.stdout.write("\n".join(lines[-40:]) + "\n\n")
+        for f in failures:
+            print(f"FAIL: {f}")
+        sys.exit(1)
+    print(f"ok: {len(checks['expect'])} expectations, {len(lines)} output lines")
+
+
+if __name__ == "__main__":
+    main()
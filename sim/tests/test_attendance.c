@@ -0,0 +1,200 @@
+// The attendance log of attendance.c on the simulated RAM flash: records batched
+// into page programs, the sector ring wrapping with even wear, mounting from the
+// highest sequence number, and a page program cut short by a power loss.
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "attendance.h"
+#include "sim.h"
+#include "check.h"
+
+#define RECORDS_PER_PAGE (FLASH_PAGE_SIZE / sizeof(attendance_record))
+#define RECORDS_PER_SECTOR (FLASH_SECTOR_SIZE / sizeof(attendance_record))
+#define TOTAL_SLOTS (ATTENDANCE_SECTORS * RECORDS_PER_SECTOR)
+#define LOG_OFFSET (PICO_FLASH_SIZE_BYTES - ATTENDANCE_SECTORS * FLASH_SECTOR_SIZE)
+
+static uint8_t crc8(const uint8_t *data, uint len) {
+    uint8_t crc = 0;
+    while (len--) {
+        crc ^= *data++;
+        for (int i = 0; i < 8; i++)
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+    return crc;
+}
+
+static bool crc_ok(const attendance_record *r) {
+    return r->crc == crc8((const uint8_t *)r, sizeof(*r) - 1);
+}
+
+// What an export from seq 0 would read: records with a good CRC, in ring order
+static struct {
+    uint32_t count;
+    uint32_t bad_crc;
+    uint32_t first_seq, last_seq;
+    bool in_order;  // Each seq one above the previous
+} scan;
+
+static void read_log(void) {
+    attendance_iter it;
+    const attendance_record *r;
+
+    memset(&scan, 0, sizeof(scan));
+    scan.in_order = true;
+    attendance_iter_begin(&it, 0);
+    while ((r = attendance_iter_next(&it))) {
+        if (!crc_ok(r)) {
+            scan.bad_crc++;
+            continue;
+        }
+        if (scan.count == 0)
+            scan.first_seq = r->seq;
+        else if (r->seq != scan.last_seq + 1)
+            scan.in_order = false;
+        scan.last_seq = r->seq;
+        scan.count++;
+    }
+}
+
+static void fresh_log(void) {
+    sim_flash_wipe();
+    sim_flash_reset_stats();
+    attendance_init();
+}
+
+static void append(uint32_t count, uint8_t type) {
+    for (uint32_t i = 0; i < count; i++)
+        CHECK(attendance_append(type));
+}
+
+static uint32_t programs(void) {
+    sim_flash_stats st;
+    sim_flash_get_stats(&st);
+    return st.programs;
+}
+
+static void test_records_are_batched_per_page(void) {
+    fresh_log();
+    append(10, ATTENDANCE_PRESENCE);
+    CHECK_EQ(programs(), 0);  // Still in the RAM page
+
+    attendance_sync();
+    CHECK_EQ(programs(), 1);
+    attendance_sync();
+    CHECK_EQ(programs(), 1);  // Nothing new: no program
+
+    append(RECORDS_PER_PAGE - 10, ATTENDANCE_PRESENCE);
+    CHECK_EQ(programs(), 2);  // The page filled up and went out by itself
+    append(1, ATTENDANCE_PRESENCE);
+    CHECK_EQ(programs(), 2);
+
+    read_log();
+    CHECK_EQ(scan.count, RECORDS_PER_PAGE + 1);
+    CHECK_EQ(scan.first_seq, 1);
+    CHECK(scan.in_order);
+}
+
+static void test_ring_wraps_with_even_wear(void) {
+    fresh_log();
+    append(TOTAL_SLOTS, ATTENDANCE_PRESENCE);
+    CHECK_EQ(sim_flash_sector_erases(LOG_OFFSET), 0);  // Blank flash: nothing to erase yet
+
+    // One sector into the second pass: only the oldest sector was erased
+    append(RECORDS_PER_SECTOR, ATTENDANCE_PRESENCE);
+    attendance_sync();
+    CHECK_EQ(sim_flash_sector_erases(LOG_OFFSET), 1);
+    CHECK_EQ(sim_flash_sector_erases(LOG_OFFSET + FLASH_SECTOR_SIZE), 0);
+
+    read_log();
+    CHECK_EQ(scan.count, TOTAL_SLOTS);
+    CHECK_EQ(scan.first_seq, RECORDS_PER_SECTOR + 1);
+    CHECK_EQ(scan.last_seq, TOTAL_SLOTS + RECORDS_PER_SECTOR);
+    CHECK(scan.in_order);
+
+    // After three passes in all, every sector was erased exactly twice
+    append(2 * TOTAL_SLOTS - RECORDS_PER_SECTOR, ATTENDANCE_PRESENCE);
+    attendance_sync();
+    for (uint s = 0; s < ATTENDANCE_SECTORS; s++)
+        CHECK_EQ(sim_flash_sector_erases(LOG_OFFSET + s * FLASH_SECTOR_SIZE), 2);
+    CHECK_EQ(attendance_next_seq(), 3 * TOTAL_SLOTS + 1);
+}
+
+static void test_mount_continues_after_highest_seq(void) {
+    fresh_log();
+    append(100, ATTENDANCE_PRESENCE);
+    append(1, ATTENDANCE_RESET);
+    append(5, ATTENDANCE_PRESENCE);
+    attendance_sync();
+    CHECK_EQ(attendance_session(), 1);
+
+    // Unsynced records are lost with the power, the synced ones are found
+    append(3, ATTENDANCE_PRESENCE);
+    attendance_init();
+    CHECK_EQ(attendance_next_seq(), 107);
+    CHECK_EQ(attendance_session(), 1);
+
+    // Mounting again does not write anything by itself
+    sim_flash_reset_stats();
+    attendance_sync();
+    CHECK_EQ(programs(), 0);
+
+    append(1, ATTENDANCE_PRESENCE);
+    read_log();
+    CHECK_EQ(scan.count, 107);
+    CHECK_EQ(scan.last_seq, 107);
+    CHECK(scan.in_order);
+
+    // The highest seq sits mid-ring once the log has wrapped; the ring then
+    // holds the other sectors in full and the head sector up to it
+    append(TOTAL_SLOTS + 40, ATTENDANCE_PRESENCE);
+    attendance_sync();
+    uint32_t next = attendance_next_seq();
+    attendance_init();
+    CHECK_EQ(attendance_next_seq(), next);
+    append(1, ATTENDANCE_PRESENCE);
+    read_log();
+    CHECK_EQ(scan.count, TOTAL_SLOTS - RECORDS_PER_SECTOR + (next - 1) % RECORDS_PER_SECTOR + 1);
+    CHECK_EQ(scan.last_seq, next);
+    CHECK(scan.in_order);
+}
+
+static void test_torn_page_program(void) {
+    fresh_log();
+    append(RECORDS_PER_PAGE + 4, ATTENDANCE_PRESENCE);
+    attendance_sync();  // Seqs 1..20 on flash
+
+    // Seqs 21..23 go to slots 4..6 of the second page; the power fails 7
+    // bytes into seq 21, so 22 and 23 never reach the flash
+    append(3, ATTENDANCE_PRESENCE);
+    sim_flash_tear_next_program(4 * sizeof(attendance_record) + 7);
+    attendance_sync();
+
+    attendance_init();
+    CHECK_EQ(attendance_next_seq(), 21);
+    read_log();
+    CHECK_EQ(scan.count, 20);
+    CHECK_EQ(scan.bad_crc, 0);  // The torn seq is not below the next one: not read
+
+    // New records go after the torn slot, not over it; from now on the torn one
+    // is read too, and dropped by its CRC
+    append(2, ATTENDANCE_PRESENCE);
+    attendance_sync();
+    attendance_init();
+    CHECK_EQ(attendance_next_seq(), 23);
+    read_log();
+    CHECK_EQ(scan.count, 22);
+    CHECK_EQ(scan.bad_crc, 1);
+    CHECK_EQ(scan.last_seq, 22);
+    CHECK(scan.in_order);
+}
+
+int main(void) {
+    sim_keep_running();
+    sim_set_trace(false);
+
+    RUN_TEST(test_records_are_batched_per_page);
+    RUN_TEST(test_ring_wraps_with_even_wear);
+    RUN_TEST(test_mount_continues_after_highest_seq);
+    RUN_TEST(test_torn_page_program);
+    return CHECK_RESULT();
+}
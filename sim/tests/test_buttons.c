@@ -0,0 +1,187 @@
+// Button debounce of buttons.c on simulated GPIO edges: clean presses, contact
+// bounce, and a last edge that lands inside the debounce window, which has to
+// be picked up when the window closes instead of being lost; and an edge that
+// finds the queue full, which must reach the consumer once there is room.
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "buttons.h"
+#include "sim.h"
+#include "check.h"
+
+#define PIN 5
+#define MAX_EVENTS 16
+
+static button_event events[MAX_EVENTS];
+static uint event_count;
+
+// Collects the PRESS/RELEASE events queued so far
+static void drain(void) {
+    button_event ev;
+
+    event_count = 0;
+    while (buttons_get_event(&ev))
+        if ((ev.type == BUTTON_PRESS || ev.type == BUTTON_RELEASE) && event_count < MAX_EVENTS)
+            events[event_count++] = ev;
+}
+
+// Drives the pin through `levels`, one every `step_us`, starting now
+static uint32_t bounce(const bool *levels, uint count, uint32_t step_us) {
+    uint32_t t0 = time_us_32();
+
+    for (uint i = 0; i < count; i++) {
+        if (i)
+            sleep_us(step_us);
+        sim_gpio_drive(PIN, levels[i]);
+    }
+    return t0;
+}
+
+// Leaves the button released and idle, well past any debounce window
+static void settle_released(void) {
+    sim_gpio_drive(PIN, 1);
+    sleep_ms(100);
+    drain();
+    CHECK(!buttons_is_pressed(PIN));
+}
+
+static void test_clean_press_and_release(void) {
+    settle_released();
+    uint32_t t0 = time_us_32();
+    sim_gpio_drive(PIN, 0);
+    drain();
+    CHECK_EQ(event_count, 1);
+    CHECK_EQ(events[0].type, BUTTON_PRESS);
+    CHECK_EQ(events[0].time_us, t0);
+
+    sleep_ms(100);
+    sim_gpio_drive(PIN, 1);
+    drain();
+    CHECK_EQ(event_count, 1);
+    CHECK_EQ(events[0].type, BUTTON_RELEASE);
+}
+
+static void test_bounce_settling_pressed(void) {
+    static const bool levels[] = {0, 1, 0, 1, 0};
+
+    settle_released();
+    bounce(levels, count_of(levels), 1000);
+    sleep_ms(50);
+    drain();
+    CHECK_EQ(event_count, 1);
+    CHECK_EQ(events[0].type, BUTTON_PRESS);
+    CHECK(buttons_is_pressed(PIN));
+}
+
+static void test_last_edge_inside_window_is_kept(void) {
+    // a tap shorter than the window: the release edge is inside it and used to
+    // be dropped, leaving the button seen as held until the next edge
+    static const bool levels[] = {0, 1};
+
+    settle_released();
+    uint32_t t0 = bounce(levels, count_of(levels), 5000);
+    drain();
+    CHECK_EQ(event_count, 1);
+    CHECK(buttons_is_pressed(PIN));
+
+    sleep_ms(50);
+    drain();
+    CHECK_EQ(event_count, 1);
+    CHECK_EQ(events[0].type, BUTTON_RELEASE);
+    CHECK_EQ(events[0].time_us, t0 + BUTTON_DEBOUNCE_US);
+    CHECK(!buttons_is_pressed(PIN));
+}
+
+static void test_release_bounce_settling_released(void) {
+    static const bool levels[] = {1, 0, 1, 0, 1};
+
+    settle_released();
+    sim_gpio_drive(PIN, 0);
+    sleep_ms(100);
+    drain();
+
+    bounce(levels, count_of(levels), 2000);
+    sleep_ms(50);
+    drain();
+    CHECK_EQ(event_count, 1);
+    CHECK_EQ(events[0].type, BUTTON_RELEASE);
+    CHECK(!buttons_is_pressed(PIN));
+}
+
+static void test_bounce_ending_back_low_after_window(void) {
+    // press, a bounce that ends released inside the window, then pressed again
+    // after it: release and press both come through, in order
+    static const bool levels[] = {0, 1};
+
+    settle_released();
+    bounce(levels, count_of(levels), 10000);
+    sleep_ms(15);
+    sim_gpio_drive(PIN, 0);
+    sleep_ms(50);
+    drain();
+    CHECK_EQ(event_count, 3);
+    CHECK_EQ(events[0].type, BUTTON_PRESS);
+    CHECK_EQ(events[1].type, BUTTON_RELEASE);
+    CHECK_EQ(events[2].type, BUTTON_PRESS);
+    CHECK(buttons_is_pressed(PIN));
+    CHECK_EQ(buttons_dropped(), 0);
+}
+
+static void test_change_dropped_on_full_queue_is_delivered(void) {
+    // the consumer stops reading (the joystick HOLD state skips the buttons)
+    // while the queue fills, and the release that finds it full is dropped; the
+    // next press used to be a no-op because the debouncer had taken the release
+    button_event ev;
+    uint count = 0;
+    button_event last = {0};
+
+    settle_released();
+    sim_gpio_drive(PIN, 0);
+    sleep_ms(100);
+    drain();
+    for (uint i = 0; i < BUTTON_QUEUE_LEN / 2; i++) {
+        sim_gpio_drive(PIN, 1);
+        sleep_ms(30);
+        sim_gpio_drive(PIN, 0);
+        sleep_ms(30);
+    }
+    uint32_t t_release = time_us_32();
+    sim_gpio_drive(PIN, 1);
+    sleep_ms(50);
+    CHECK_EQ(buttons_dropped(), 1);
+    CHECK(buttons_is_pressed(PIN));  // Still what the consumer is about to see
+
+    while (buttons_get_event(&ev))
+        if (ev.type == BUTTON_PRESS || ev.type == BUTTON_RELEASE) {
+            count++;
+            last = ev;
+        }
+    CHECK_EQ(count, BUTTON_QUEUE_LEN + 1);
+    CHECK_EQ(last.type, BUTTON_RELEASE);
+    CHECK_EQ(last.time_us, t_release);
+    CHECK(!buttons_is_pressed(PIN));
+
+    sleep_ms(100);
+    sim_gpio_drive(PIN, 0);
+    drain();
+    CHECK_EQ(event_count, 1);
+    CHECK_EQ(events[0].type, BUTTON_PRESS);
+}
+
+int main(void) {
+    static const uint pins[] = {PIN};
+
+    sim_keep_running();
+    sim_set_trace(false);
+    gpio_init(PIN);
+    gpio_set_dir(PIN, GPIO_IN);
+    gpio_pull_up(PIN);
+    buttons_init(pins, count_of(pins));
+
+    RUN_TEST(test_clean_press_and_release);
+    RUN_TEST(test_bounce_settling_pressed);
+    RUN_TEST(test_last_edge_inside_window_is_kept);
+    RUN_TEST(test_release_bounce_settling_released);
+    RUN_TEST(test_bounce_ending_back_low_after_window);
+    RUN_TEST(test_change_dropped_on_full_queue_is_delivered);
+    return CHECK_RESULT();
+}
@@ -0,0 +1,236 @@
+// Asynchronous flush state machine of ssd1306_i2c.c on the simulated I2C/DMA:
+// start, poll and complete; abort and resend after a NAK or a timeout; the
+// blocking path when no DMA channel is left; the bus after a clk_sys change.
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/i2c.h"
+#include "ssd1306.h"
+#include "sim.h"
+#include "check.h"
+
+static uint8_t frame[SSD1306_FRAME_LEN];
+static uint16_t flush_tx[SSD1306_FRAME_LEN];
+static ssd1306_t disp;
+
+static int done_calls;
+static bool done_ok;
+
+static void on_done(bool ok) {
+    done_calls++;
+    done_ok = ok;
+}
+
+static void fill(uint8_t seed) {
+    for (uint i = 0; i < SSD1306_BUF_LEN; i++)
+        disp.buf[i] = (uint8_t)(seed + i * 7);
+}
+
+static bool bus_panel_holds(uint bus, uint8_t seed) {
+    for (uint page = 0; page < SSD1306_NUM_PAGES; page++) {
+        const uint8_t *ram = ssd1306_sim_page(bus, SSD1306_I2C_ADDR, page);
+        for (int col = 0; col < SSD1306_WIDTH; col++)
+            if (ram[col] != (uint8_t)(seed + (page * SSD1306_WIDTH + col) * 7))
+                return false;
+    }
+    return true;
+}
+
+static bool panel_holds(uint8_t seed) {
+    return bus_panel_holds(1, seed);
+}
+
+// Starts a flush of the whole frame and returns the time it started at
+static uint64_t start_flush(void) {
+    done_calls = 0;
+    done_ok = false;
+    uint64_t t0 = time_us_64();
+    ssd1306_show_async(&disp, on_done);
+    return t0;
+}
+
+static void test_async_completes(void) {
+    sim_i2c_stats stats;
+
+    fill(1);
+    sim_i2c_reset_stats();
+    uint64_t t0 = start_flush();
+    CHECK(disp.flush_busy);
+    CHECK(!ssd1306_flush_poll(&disp));
+    CHECK_EQ(done_calls, 0);
+
+    // the frame buffer is free as soon as the flush has started
+    fill(2);
+    ssd1306_flush_wait(&disp);
+    sim_i2c_get_stats(&stats);
+
+    CHECK_EQ(done_calls, 1);
+    CHECK(done_ok);
+    CHECK(!disp.flush_busy);
+    CHECK(ssd1306_flush_poll(&disp));
+    CHECK(time_us_64() - t0 >= stats.bus_time_us);
+    CHECK(panel_holds(1));
+}
+
+static void test_blocking_write_waits_for_flush(void) {
+    fill(3);
+    start_flush();
+    ssd1306_send_cmd(&disp, SSD1306_NOP);
+    CHECK_EQ(done_calls, 1);
+    CHECK(done_ok);
+    CHECK(panel_holds(3));
+}
+
+static void test_timeout_aborts_and_resends_slower(void) {
+    sim_i2c_set_max_khz(0);
+    CHECK_EQ(ssd1306_negotiate_clock(&disp), 1800);
+
+    fill(4);
+    sim_i2c_stall_next(1);
+    uint64_t t0 = start_flush();
+    ssd1306_flush_wait(&disp);
+
+    CHECK_EQ(done_calls, 1);
+    CHECK(done_ok);
+    CHECK_EQ(i2c1->baudrate, 1400000);
+    // nothing moved until the deadline: at 1800 kHz, 2 x 526 bytes x 9 clocks + 1 ms
+    CHECK(time_us_64() - t0 >= 2 * (SSD1306_FRAME_LEN + 1) * 9 * 1000 / 1800 + 1000);
+    CHECK(panel_holds(4));
+}
+
+static void test_nak_resends_slower(void) {
+    sim_i2c_set_max_khz(1000);
+
+    fill(5);
+    start_flush();
+    ssd1306_flush_wait(&disp);
+
+    CHECK_EQ(done_calls, 1);
+    CHECK(done_ok);
+    CHECK_EQ(i2c1->baudrate, 1000000);
+    CHECK(panel_holds(5));
+}
+
+static void test_gives_up_at_slowest_speed(void) {
+    sim_i2c_set_max_khz(400);
+    fill(6);
+    start_flush();
+    ssd1306_flush_wait(&disp);
+    CHECK(done_ok);
+    CHECK_EQ(i2c1->baudrate, 400000);
+
+    fill(7);
+    sim_i2c_stall_next(1);
+    start_flush();
+    ssd1306_flush_wait(&disp);
+    CHECK_EQ(done_calls, 1);
+    CHECK(!done_ok);
+    CHECK(!disp.flush_busy);
+
+    // the bus is released: the next flush goes through
+    start_flush();
+    ssd1306_flush_wait(&disp);
+    CHECK(done_ok);
+    CHECK(panel_holds(7));
+}
+
+static void test_reclock_keeps_negotiated_speed(void) {
+    sim_i2c_stats stats;
+
+    sim_i2c_set_max_khz(0);
+    CHECK_EQ(ssd1306_negotiate_clock(&disp), 1800);
+
+    set_sys_clock_khz(48000, true);
+    ssd1306_reclock(&disp);
+    fill(10);
+    sim_i2c_reset_stats();
+    ssd1306_show(&disp);
+    sim_i2c_get_stats(&stats);
+    // no timeout and no step down: the bus runs at 1800 kHz on the slower clock
+    CHECK_EQ(i2c1->baudrate, 1800000);
+    CHECK_EQ(stats.transactions, 1);
+    CHECK(stats.bus_time_us <= (SSD1306_FRAME_LEN + 1) * 9 * 1000 / 1800 + 1);
+    CHECK(panel_holds(10));
+
+    set_sys_clock_khz(125000, true);
+    ssd1306_reclock(&disp);
+    fill(11);
+    start_flush();
+    ssd1306_flush_wait(&disp);
+    CHECK(done_ok);
+    CHECK_EQ(i2c1->baudrate, 1800000);
+    CHECK(panel_holds(11));
+}
+
+static void test_stale_dividers_slow_the_bus(void) {
+    static uint8_t frame0[SSD1306_FRAME_LEN];
+    ssd1306_t other;
+    sim_i2c_stats stats;
+    uint64_t nominal_us = ((SSD1306_FRAME_LEN + 1) * 9 + 2) * 1000 / SSD1306_I2C_CLK;
+
+    // a fixed rate bus, its dividers computed at 125 MHz
+    CHECK(ssd1306_sim_attach(0, SSD1306_I2C_ADDR));
+    i2c_init(i2c0, SSD1306_I2C_CLK * 1000);
+    ssd1306_setup(&other, i2c0, SSD1306_I2C_ADDR, SSD1306_WIDTH, SSD1306_HEIGHT, frame0);
+
+    // at 48 MHz the same dividers give 154 kHz instead of 400
+    set_sys_clock_khz(48000, true);
+    sim_i2c_reset_stats();
+    ssd1306_show(&other);
+    sim_i2c_get_stats(&stats);
+    CHECK(stats.bus_time_us > nominal_us * 125 / 48 - 2);
+
+    ssd1306_reclock(&other);
+    CHECK_EQ(i2c0->baudrate, SSD1306_I2C_CLK * 1000);
+    sim_i2c_reset_stats();
+    ssd1306_show(&other);
+    sim_i2c_get_stats(&stats);
+    CHECK(stats.bus_time_us <= nominal_us + 1);
+
+    set_sys_clock_khz(125000, true);
+    ssd1306_reclock(&other);
+}
+
+static void test_no_channel_falls_back_to_blocking(void) {
+    static uint8_t frame2[SSD1306_FRAME_LEN];
+    static uint16_t flush_tx2[SSD1306_FRAME_LEN];
+    ssd1306_t other;
+
+    while (dma_claim_unused_channel(false) >= 0)
+        ;
+    ssd1306_setup(&other, i2c1, SSD1306_I2C_ADDR, SSD1306_WIDTH, SSD1306_HEIGHT, frame2);
+    ssd1306_dma_init(&other, flush_tx2);
+    CHECK(other.dma_chan < 0);
+
+    for (uint i = 0; i < SSD1306_BUF_LEN; i++)
+        other.buf[i] = (uint8_t)(8 + i * 7);
+    done_calls = 0;
+    ssd1306_show_async(&other, on_done);
+
+    // done before returning, without ever going busy
+    CHECK_EQ(done_calls, 1);
+    CHECK(done_ok);
+    CHECK(!other.flush_busy);
+    CHECK(panel_holds(8));
+}
+
+int main(void) {
+    sim_keep_running();
+    sim_i2c_dma_timed(true);
+
+    i2c_init(i2c1, SSD1306_I2C_CLK * 1000);
+    ssd1306_setup(&disp, i2c1, SSD1306_I2C_ADDR, SSD1306_WIDTH, SSD1306_HEIGHT, frame);
+    ssd1306_init(&disp);
+    ssd1306_dma_init(&disp, flush_tx);
+    CHECK(disp.dma_chan >= 0);
+
+    RUN_TEST(test_async_completes);
+    RUN_TEST(test_blocking_write_waits_for_flush);
+    RUN_TEST(test_reclock_keeps_negotiated_speed);
+    RUN_TEST(test_stale_dividers_slow_the_bus);
+    RUN_TEST(test_timeout_aborts_and_resends_slower);
+    RUN_TEST(test_nak_resends_slower);
+    RUN_TEST(test_gives_up_at_slowest_speed);
+    RUN_TEST(test_no_channel_falls_back_to_blocking);
+    return CHECK_RESULT();
+}
@@ -0,0 +1,226 @@
+// Replays transition traces through the kiosk and joystick machines of kiosk.c.
+//
+// A trace is what the firmware prints with tracing on ('+' on the USB console):
+// one "F <machine> <from> <event> <to> <time_us>" line per transition, any other
+// line ignored. Each line is fed back, with its time, to fsm_dispatch (or to
+// fsm_poll for TIMEOUT), and the machine must be in <from> before and in <to>
+// after. The guards are the real ones, so the timing of the trace decides the
+// debounce outcome again.
+//
+//   test_fsm                 built-in traces
+//   test_fsm FILE...         replay each file ("-" reads standard input)
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "kiosk.h"
+#include "check.h"
+
+enum { ACT_SHOW_A, ACT_SHOW_B, ACT_CONFIRM, ACT_RESET, ACT_RESTART, ACT_RESTART_DONE,
+       ACT_LED_ON, ACT_LED_OFF, NUM_ACTIONS };
+
+static int actions[NUM_ACTIONS];
+static fsm kiosk, joystick;
+
+void show_button_a(fsm *m) { actions[ACT_SHOW_A]++; }
+void show_button_b(fsm *m) { actions[ACT_SHOW_B]++; }
+void confirm_presence(fsm *m) { actions[ACT_CONFIRM]++; }
+void reset_session(fsm *m) { actions[ACT_RESET]++; }
+void restart_system(fsm *m) { actions[ACT_RESTART]++; }
+void restart_done(fsm *m) { actions[ACT_RESTART_DONE]++; }
+void joystick_led_on(fsm *m) { actions[ACT_LED_ON]++; }
+void joystick_led_off(fsm *m) { actions[ACT_LED_OFF]++; }
+
+// The trace has no button levels. A is down exactly while the kiosk is between
+// a traced A_PRESS and its A_RELEASE, which always has a transition; a press
+// held across a restart is not traced, but then no TICK leaves HOLD either.
+bool button_a_up(const fsm *m, uint32_t time_us) {
+    return kiosk.state != ST_DEBOUNCING_A && kiosk.state != ST_RELEASE_A;
+}
+
+static void reset(void) {
+    memset(actions, 0, sizeof(actions));
+    fsm_start(&kiosk, &kiosk_def, 0);
+    fsm_start(&joystick, &joystick_def, 0);
+}
+
+static int lookup(const char *const *names, int first, int count, const char *name) {
+    for (int i = first; i < count; i++)
+        if (!strcmp(names[i], name))
+            return i;
+    return -1;
+}
+
+static int state_index(const fsm *m, const char *name) {
+    for (int i = 1; i < m->def->num_states; i++)
+        if (!strcmp(m->def->states[i].name, name))
+            return i;
+    return -1;
+}
+
+// Applies one trace line; returns false, with a message, if the machines do not
+// take the same transition. Lines that are not transitions are accepted.
+static bool replay_line(const char *line, const char *where) {
+    char machine[16], from[24], event[24], to[24];
+    unsigned long t;
+
+    if (strncmp(line, "F ", 2))
+        return true;
+    if (sscanf(line, "F %15s %23s %23s %23s %lu", machine, from, event, to, &t) != 5) {
+        fprintf(stderr, "%s: malformed: %s", where, line);
+        return false;
+    }
+
+    fsm *m = !strcmp(machine, "kiosk") ? &kiosk : !strcmp(machine, "joystick") ? &joystick : NULL;
+    int ev = lookup(event_names, 0, NUM_EVENTS, event);
+    if (!m || ev < 0 || state_index(m, from) < 0 || state_index(m, to) < 0) {
+        fprintf(stderr, "%s: unknown machine, state or event: %s", where, line);
+        return false;
+    }
+    if (m->state != state_index(m, from)) {
+        fprintf(stderr, "%s: %s is in %s, trace has it in %s\n", where, machine,
+                fsm_state_name(m, m->state), from);
+        return false;
+    }
+
+    bool moved = ev == m->def->timeout_event ? fsm_poll(m, (uint32_t)t) : fsm_dispatch(m, ev, (uint32_t)t);
+    if (!moved || m->state != state_index(m, to)) {
+        fprintf(stderr, "%s: %s %s on %s went to %s, trace has %s\n", where, machine, from, event,
+                moved ? fsm_state_name(m, m->state) : "nowhere", to);
+        return false;
+    }
+    return true;
+}
+
+static bool replay_stream(FILE *f, const char *name) {
+    char line[160], where[200];
+    int n = 0;
+
+    while (fgets(line, sizeof(line), f)) {
+        snprintf(where, sizeof(where), "%s:%d", name, ++n);
+        if (!replay_line(line, where))
+            return false;
+    }
+    return true;
+}
+
+static bool replay(const char *const *lines) {
+    reset();
+    for (int i = 0; lines[i]; i++)
+        if (!replay_line(lines[i], "built-in"))
+            return false;
+    return true;
+}
+
+static void test_long_press_confirms(void) {
+    static const char *const trace[] = {
+        "F kiosk IDLE A_PRESS DEBOUNCING_A 1000000\n",
+        "F kiosk DEBOUNCING_A TIMEOUT RELEASE_A 1050000\n",
+        "F kiosk RELEASE_A A_RELEASE IDLE 1200000\n",
+        NULL};
+    CHECK(replay(trace));
+    CHECK_EQ(actions[ACT_SHOW_A], 1);
+    CHECK_EQ(actions[ACT_CONFIRM], 1);
+}
+
+static void test_release_after_debounce_confirms(void) {
+    // released past 50 ms but before the timeout was polled
+    static const char *const trace[] = {
+        "F kiosk IDLE A_PRESS DEBOUNCING_A 1000000\n",
+        "F kiosk DEBOUNCING_A A_RELEASE IDLE 1050500\n",
+        NULL};
+    CHECK(replay(trace));
+    CHECK_EQ(actions[ACT_CONFIRM], 1);
+}
+
+static void test_short_press_is_ignored(void) {
+    static const char *const trace[] = {
+        "F kiosk IDLE A_PRESS DEBOUNCING_A 1000000\n",
+        "F kiosk DEBOUNCING_A A_RELEASE IDLE 1020000\n",
+        "F kiosk IDLE B_PRESS DEBOUNCING_B 2000000\n",
+        "F kiosk DEBOUNCING_B B_RELEASE IDLE 2030000\n",
+        NULL};
+    CHECK(replay(trace));
+    CHECK_EQ(actions[ACT_CONFIRM], 0);
+    CHECK_EQ(actions[ACT_RESET], 0);
+}
+
+static void test_reset_restarts_after_timeouts(void) {
+    static const char *const trace[] = {
+        "F kiosk IDLE B_PRESS DEBOUNCING_B 1000000\n",
+        "F kiosk DEBOUNCING_B TIMEOUT RELEASE_B 1050000\n",
+        "F kiosk RELEASE_B B_RELEASE RESETTING 1100000\n",
+        "F kiosk RESETTING TIMEOUT RESTARTING 6100000\n",
+        "F kiosk RESTARTING TIMEOUT IDLE 11100000\n",
+        NULL};
+    CHECK(replay(trace));
+    CHECK_EQ(actions[ACT_RESET], 1);
+    CHECK_EQ(actions[ACT_RESTART], 1);
+    CHECK_EQ(actions[ACT_RESTART_DONE], 1);
+}
+
+static void test_joystick_waits_for_button_a(void) {
+    static const char *const trace[] = {
+        "F joystick IDLE JOYSTICK HOLD 500000\n",
+        "F kiosk IDLE A_PRESS DEBOUNCING_A 600000\n",
+        "F kiosk DEBOUNCING_A TIMEOUT RELEASE_A 650000\n",
+        "F kiosk RELEASE_A A_RELEASE IDLE 700000\n",
+        "F joystick HOLD TICK IDLE 701000\n",
+        NULL};
+    CHECK(replay(trace));
+    CHECK_EQ(actions[ACT_LED_ON], 1);
+    CHECK_EQ(actions[ACT_LED_OFF], 1);
+
+    // with A still down, the tick has no transition
+    static const char *const held[] = {
+        "F kiosk IDLE A_PRESS DEBOUNCING_A 600000\n",
+        "F joystick IDLE JOYSTICK HOLD 610000\n",
+        "F joystick HOLD TICK IDLE 611000\n",
+        NULL};
+    CHECK(!replay(held));
+}
+
+static void test_diverging_trace_is_caught(void) {
+    // a timeout the table does not have, one before its deadline, and a
+    // release too short to have been taken
+    static const char *const no_cell[] = {"F kiosk IDLE TIMEOUT RELEASE_A 1000\n", NULL};
+    static const char *const early[] = {
+        "F kiosk IDLE B_PRESS DEBOUNCING_B 1000000\n",
+        "F kiosk DEBOUNCING_B TIMEOUT RELEASE_B 1040000\n",
+        NULL};
+    static const char *const too_short[] = {
+        "F kiosk IDLE B_PRESS DEBOUNCING_B 1000000\n",
+        "F kiosk DEBOUNCING_B B_RELEASE RESETTING 1010000\n",
+        NULL};
+    static const char *const wrong_from[] = {"F kiosk RESETTING TIMEOUT RESTARTING 1000\n", NULL};
+
+    CHECK(!replay(no_cell));
+    CHECK(!replay(early));
+    CHECK(!replay(too_short));
+    CHECK(!replay(wrong_from));
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            FILE *f = strcmp(argv[i], "-") ? fopen(argv[i], "r") : stdin;
+            CHECK(f != NULL);
+            if (!f)
+                continue;
+            reset();
+            bool ok = replay_stream(f, argv[i]);
+            CHECK(ok);
+            printf("%s %s\n", ok ? "ok  " : "FAIL", argv[i]);
+            if (f != stdin)
+                fclose(f);
+        }
+        return CHECK_RESULT();
+    }
+
+    RUN_TEST(test_long_press_confirms);
+    RUN_TEST(test_release_after_debounce_confirms);
+    RUN_TEST(test_short_press_is_ignored);
+    RUN_TEST(test_reset_restarts_after_timeouts);
+    RUN_TEST(test_joystick_waits_for_button_a);
+    RUN_TEST(test_diverging_trace_is_caught);
+    return CHECK_RESULT();
+}
@@ -0,0 +1,137 @@
+// The drawing and render paths of ssd1306_i2c.c must not touch the heap. This
+// test is linked with malloc, calloc, realloc and free wrapped, and counts every
+// call made from firmware or simulator code while a frame is drawn and sent.
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "ssd1306.h"
+#include "sim.h"
+#include "check.h"
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+static bool counting;
+static int heap_calls;
+
+void *__wrap_malloc(size_t size) {
+    heap_calls += counting;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    heap_calls += counting;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    heap_calls += counting;
+    return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void *ptr) {
+    heap_calls += counting;
+    __real_free(ptr);
+}
+
+static uint8_t frame[SSD1306_FRAME_LEN];
+static uint8_t *buf = frame + SSD1306_BUF_PREFIX;
+static const uint8_t flash_frame[SSD1306_FRAME_LEN] = {SSD1306_FRAME_HDR(SSD1306_WIDTH, SSD1306_NUM_PAGES)};
+
+static void on_done(bool ok) {
+    (void)ok;
+}
+
+static bool panel_matches(const uint8_t *pixels) {
+    for (uint page = 0; page < SSD1306_NUM_PAGES; page++)
+        if (memcmp(ssd1306_sim_page(1, SSD1306_I2C_ADDR, page), pixels + page * SSD1306_WIDTH,
+                   SSD1306_WIDTH))
+            return false;
+    return true;
+}
+
+static void begin(void) {
+    heap_calls = 0;
+    counting = true;
+}
+
+static void end(void) {
+    counting = false;
+}
+
+static void test_render_does_not_allocate(void) {
+    struct render_area area = {
+        .start_col = 0, .end_col = SSD1306_WIDTH - 1, .start_page = 0, .end_page = SSD1306_NUM_PAGES - 1};
+    calc_render_area_buflen(&area);
+
+    begin();
+    FillRect(buf, 0, 0, SSD1306_WIDTH, SSD1306_HEIGHT, false);
+    WriteString(buf, 5, 0, "PRESENCA");
+    WriteStringFont(buf, &ssd1306_font_8x8, 5, 8, "CONFIRMADA");
+    DrawLine(buf, 0, 31, 127, 16, true);
+    render(buf, &area);
+    end();
+    CHECK_EQ(heap_calls, 0);
+    CHECK(panel_matches(buf));
+}
+
+static void test_render_dirty_does_not_allocate(void) {
+    uint8_t before[SSD1306_FRAME_LEN];
+
+    begin();
+    InvertRect(buf, 40, 10, 20, 12);
+    SetPixel(buf, 127, 31, true);
+    memcpy(before, frame, sizeof(frame));
+    render_dirty(buf);
+    end();
+    CHECK_EQ(heap_calls, 0);
+    // the spans went out without the pixels in front of them being touched
+    CHECK(memcmp(before + SSD1306_BUF_PREFIX, buf, SSD1306_BUF_LEN) == 0);
+    CHECK(panel_matches(buf));
+}
+
+static void test_render_async_does_not_allocate(void) {
+    struct render_area area = {
+        .start_col = 0, .end_col = SSD1306_WIDTH - 1, .start_page = 0, .end_page = SSD1306_NUM_PAGES - 1};
+    calc_render_area_buflen(&area);
+
+    begin();
+    FillRect(buf, 10, 4, 30, 20, true);
+    render_async(buf, &area, on_done);
+    SSD1306_flush_wait();
+    end();
+    CHECK_EQ(heap_calls, 0);
+    CHECK(panel_matches(buf));
+}
+
+static void test_render_frame_does_not_allocate(void) {
+    begin();
+    render_frame(flash_frame);
+    end();
+    CHECK_EQ(heap_calls, 0);
+    CHECK(panel_matches(flash_frame + SSD1306_BUF_PREFIX));
+}
+
+int main(void) {
+    sim_keep_running();
+    sim_set_trace(false);
+
+    i2c_init(i2c1, SSD1306_I2C_CLK * 1000);
+    SSD1306_init();
+    SSD1306_dma_init();
+
+    // the counter has to see allocations at all, or a zero proves nothing
+    begin();
+    free(malloc(16));
+    end();
+    CHECK_EQ(heap_calls, 2);
+
+    RUN_TEST(test_render_does_not_allocate);
+    RUN_TEST(test_render_dirty_does_not_allocate);
+    RUN_TEST(test_render_async_does_not_allocate);
+    RUN_TEST(test_render_frame_does_not_allocate);
+    return CHECK_RESULT();
+}
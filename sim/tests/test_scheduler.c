@@ -0,0 +1,165 @@
+// scheduler.c on a virtual clock of its own: one-shot and periodic timers, late
+// periodic timers, stale timer ids and events posted between timers. Idle waits
+// go through the installed wait function, which jumps straight to the deadline.
+#include "pico/stdlib.h"
+#include "scheduler.h"
+#include "check.h"
+
+#define MAX_RUNS 64
+
+static uint64_t virtual_us;
+static uint waits;
+
+static uint64_t virtual_clock(void) {
+    return virtual_us;
+}
+
+static void virtual_wait(uint64_t deadline_us) {
+    CHECK(deadline_us != UINT64_MAX);  // every test runs to a finite limit
+    CHECK(deadline_us > virtual_us);   // never asked to wait for a deadline already due
+    waits++;
+    virtual_us = deadline_us;
+}
+
+// When each task ran, in virtual microseconds, tagged with its argument
+static struct {
+    uint64_t at_us;
+    uintptr_t tag;
+} runs[MAX_RUNS];
+static uint run_count;
+
+static void record(void *arg) {
+    if (run_count < MAX_RUNS)
+        runs[run_count++] = (typeof(runs[0])){virtual_us, (uintptr_t)arg};
+}
+
+// Task that runs long: the clock moves on while it executes
+static void slow(void *arg) {
+    record(arg);
+    virtual_us += 35000;
+}
+
+static void post_event(void *arg) {
+    record(arg);
+    sched_post(record, (void *)((uintptr_t)arg + 1));
+}
+
+static sched_id ids[SCHED_MAX_TIMERS];
+
+static void reset(void) {
+    for (int i = 0; i < SCHED_MAX_TIMERS; i++)
+        if (ids[i]) {
+            sched_cancel(ids[i]);
+            ids[i] = 0;
+        }
+    sched_run_until(virtual_us + 1);
+    run_count = 0;
+    waits = 0;
+}
+
+static void test_one_shot(void) {
+    reset();
+    uint64_t t0 = virtual_us;
+    ids[0] = sched_after_ms(30, record, (void *)1);
+    ids[1] = sched_after_ms(10, record, (void *)2);
+
+    sched_run_until(t0 + 100000);
+    CHECK_EQ(run_count, 2);
+    CHECK_EQ(runs[0].tag, 2);
+    CHECK_EQ(runs[0].at_us, t0 + 10000);
+    CHECK_EQ(runs[1].tag, 1);
+    CHECK_EQ(runs[1].at_us, t0 + 30000);
+    CHECK_EQ(virtual_us, t0 + 100000);
+    // two timers, then the limit: nothing polls in between
+    CHECK_EQ(waits, 3);
+    CHECK_EQ(sched_next_deadline_us(), UINT64_MAX);
+}
+
+static void test_periodic(void) {
+    reset();
+    uint64_t t0 = virtual_us;
+    ids[0] = sched_every_ms(20, record, (void *)1);
+
+    sched_run_until(t0 + 100000);
+    CHECK_EQ(run_count, 5);
+    for (uint i = 0; i < run_count; i++)
+        CHECK_EQ(runs[i].at_us, t0 + (i + 1) * 20000);
+    CHECK_EQ(sched_next_deadline_us(), t0 + 120000);
+}
+
+static void test_late_periodic_does_not_pile_up(void) {
+    reset();
+    uint64_t t0 = virtual_us;
+    ids[0] = sched_every_ms(10, slow, (void *)1);
+
+    // each run takes 35 ms, three periods and a half: the timer is due again as
+    // soon as it returns, but fires once per late run, not once per missed period
+    sched_run_until(t0 + 100000);
+    CHECK_EQ(run_count, 3);
+    CHECK_EQ(runs[0].at_us, t0 + 10000);
+    CHECK_EQ(runs[1].at_us, t0 + 45000);
+    CHECK_EQ(runs[2].at_us, t0 + 80000);
+    CHECK_EQ(sched_next_deadline_us(), t0 + 90000);
+}
+
+static void test_stale_id_does_not_cancel(void) {
+    reset();
+    uint64_t t0 = virtual_us;
+    sched_id old = sched_after_ms(5, record, (void *)1);
+
+    sched_run_until(t0 + 10000);
+    CHECK_EQ(run_count, 1);
+
+    // the slot is free again and gets reused with a new generation
+    ids[0] = sched_after_ms(5, record, (void *)2);
+    CHECK((ids[0] & 0xFF) == (old & 0xFF));
+    CHECK(ids[0] != old);
+
+    sched_cancel(old);
+    sched_run_until(t0 + 20000);
+    CHECK_EQ(run_count, 2);
+    CHECK_EQ(runs[1].tag, 2);
+
+    // and a current id still cancels
+    ids[1] = sched_after_ms(5, record, (void *)3);
+    sched_cancel(ids[1]);
+    sched_run_until(t0 + 30000);
+    CHECK_EQ(run_count, 2);
+}
+
+static void test_posted_event_runs_before_sleeping(void) {
+    reset();
+    uint64_t t0 = virtual_us;
+    ids[0] = sched_after_ms(10, post_event, (void *)10);
+
+    sched_run_until(t0 + 50000);
+    CHECK_EQ(run_count, 2);
+    CHECK_EQ(runs[1].tag, 11);
+    CHECK_EQ(runs[1].at_us, t0 + 10000);
+}
+
+static void test_table_full(void) {
+    reset();
+    for (int i = 0; i < SCHED_MAX_TIMERS; i++) {
+        ids[i] = sched_after_ms(1000, record, NULL);
+        CHECK(ids[i] >= 0);
+    }
+    CHECK(sched_after_ms(1000, record, NULL) < 0);
+}
+
+int main(void) {
+    virtual_us = 1000000;
+    sched_set_clock(virtual_clock, virtual_wait);
+
+    RUN_TEST(test_one_shot);
+    RUN_TEST(test_periodic);
+    RUN_TEST(test_late_periodic_does_not_pile_up);
+    RUN_TEST(test_stale_id_does_not_cancel);
+    RUN_TEST(test_posted_event_runs_before_sleeping);
+    RUN_TEST(test_table_full);
+
+    // the default clock is back once the virtual one is removed
+    sched_set_clock(NULL, NULL);
+    CHECK_EQ(sched_now_us(), time_us_64());
+    return CHECK_RESULT();
+}
@@ -0,0 +1,48 @@
+#include "pico/stdlib.h"
+#include "song.h"
+
+const uint16_t song_pitch_wrap[NUM_PITCHES] = {
+    [PITCH_REST] = 0,
+#define NOTE_PITCH_WRAP(name, wrap) [PITCH_##name] = wrap,
+    NOTE_TABLE(NOTE_PITCH_WRAP)
+#undef NOTE_PITCH_WRAP
+};
+
+void song_begin(song_cursor *c, const uint16_t *words) {
+    *c = (song_cursor){.words = words, .whole_note_ms = SONG_DEFAULT_WHOLE_MS};
+}
+
+// Decodifica até a próxima nota ou pausa. Retorna false no fim da música. Curta
+// e sem laços longos: roda no callback do alarme do sequenciador.
+bool song_next(song_cursor *c, song_event *ev) {
+    while (true) {
+        uint16_t w = c->words[c->pos++];
+
+        if (!(w & 0x8000)) {
+            uint pitch = w >> 8;
+            uint figure = w & 0xFF;
+            if (!figure || pitch >= NUM_PITCHES)
+                continue;  // Palavra inválida: ignora em vez de travar o áudio
+            ev->wrap = song_pitch_wrap[pitch];
+            ev->dur_us = c->whole_note_ms * 1000 / figure;
+            return true;
+        }
+
+        switch (w & 0xF000) {
+            case SONG_TEMPO(0):
+                c->whole_note_ms = w & 0xFFF;
+                break;
+            case SONG_LOOP_START:
+                c->loop_start = c->pos;
+                c->loop_done = 0;
+                break;
+            case SONG_LOOP_END(0):
+                if (++c->loop_done < (w & 0xFFFu))
+                    c->pos = c->loop_start;
+                break;
+            default:
+                c->pos--;  // Fim: chamadas seguintes continuam no fim
+                return false;
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef SONG_H_
+#define SONG_H_
+
+#include "pico/stdlib.h"
+#include "notes.h"
+
+// Formato compacto de música: uma palavra de 16 bits por evento, em vetores
+// const (flash). O decodificador lê um evento por vez, sem copiar nada para a
+// RAM, então o tamanho da música só é limitado pela flash.
+//
+//   0ppppppp ffffffff   nota PITCH_* p (0 = pausa), figura f (1 = semibreve,
+//                       2 = mínima, 4 = semínima, ...)
+//   1000tttt tttttttt   andamento: semibreve de t ms
+//   1001---- --------   início de um trecho repetido
+//   1010nnnn nnnnnnnn   fim do trecho: ele toca n vezes ao todo (sem aninhar)
+//   1111---- --------   fim da música
+
+#define SONG_NOTE(pitch, figure) ((uint16_t)(((pitch) & 0x7F) << 8 | ((figure) & 0xFF)))
+#define SONG_REST(figure) SONG_NOTE(PITCH_REST, figure)
+#define SONG_TEMPO(whole_ms) ((uint16_t)(0x8000 | ((whole_ms) & 0xFFF)))
+#define SONG_LOOP_START ((uint16_t)0x9000)
+#define SONG_LOOP_END(times) ((uint16_t)(0xA000 | ((times) & 0xFFF)))
+#define SONG_END ((uint16_t)0xF000)
+
+#define SONG_DEFAULT_WHOLE_MS 2000  // Andamento até a primeira SONG_TEMPO
+
+// Posição de leitura numa música
+typedef struct {
+    const uint16_t *words;
+    uint pos;            // Próxima palavra
+    uint loop_start;     // Primeira palavra do trecho repetido
+    uint loop_done;      // Passagens já concluídas pelo trecho
+    uint whole_note_ms;
+} song_cursor;
+
+// Próxima nota: wrap do PWM (0 = pausa) e duração
+typedef struct {
+    uint16_t wrap;
+    uint32_t dur_us;
+} song_event;
+
+extern const uint16_t song_pitch_wrap[NUM_PITCHES];
+
+extern void song_begin(song_cursor *c, const uint16_t *words);
+extern bool song_next(song_cursor *c, song_event *ev);
+
+#endif /* SONG_H_ */
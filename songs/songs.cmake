@@ -0,0 +1,28 @@
+# Songs: the note/figure tables in songs/*.inc are packed by tools/songgen.py
+# into const uint16_t arrays in flash (format in song.h). Link bitdoglab_songs
+# to get songs.h; the generated source is compiled with the consuming target,
+# so it sees the same SDK headers.
+
+find_package(Python3 REQUIRED COMPONENTS Interpreter)
+
+set(BITDOGLAB_SONGS_DIR ${CMAKE_CURRENT_LIST_DIR})
+set(BITDOGLAB_SONGS_OUT ${CMAKE_CURRENT_BINARY_DIR}/songs)
+
+add_custom_command(
+  OUTPUT ${BITDOGLAB_SONGS_OUT}/songs.c ${BITDOGLAB_SONGS_OUT}/songs.h
+  COMMAND ${CMAKE_COMMAND} -E make_directory ${BITDOGLAB_SONGS_OUT}
+  COMMAND ${Python3_EXECUTABLE} ${BITDOGLAB_SONGS_DIR}/../tools/songgen.py
+          ${BITDOGLAB_SONGS_OUT}/songs.c ${BITDOGLAB_SONGS_OUT}/songs.h
+          song_melody=${BITDOGLAB_SONGS_DIR}/melody.inc:1500
+  DEPENDS ${BITDOGLAB_SONGS_DIR}/melody.inc ${BITDOGLAB_SONGS_DIR}/../tools/songgen.py
+  VERBATIM
+)
+
+add_library(bitdoglab_songs INTERFACE)
+
+target_sources(bitdoglab_songs INTERFACE ${BITDOGLAB_SONGS_OUT}/songs.c)
+
+target_include_directories(bitdoglab_songs INTERFACE
+  ${BITDOGLAB_SONGS_OUT}
+  ${BITDOGLAB_SONGS_DIR}/..
+)
@@ -1,12 +1,62 @@
 #include "ssd1306_i2c.h"
+#include "ssd1306_fonts.h"
 extern void calc_render_area_buflen(struct render_area *area);
 extern void SSD1306_send_cmd(uint8_t cmd);
 extern void SSD1306_send_cmd_list(uint8_t *buf, int num);
 extern void SSD1306_send_buf(uint8_t buf[], int buflen);
+extern void SSD1306_mark_dirty(int x0, int x1, int page0, int page1);
+extern void SSD1306_clear_dirty();
 extern void SSD1306_init();
+extern uint SSD1306_negotiate_clock();
+extern void SSD1306_reclock();
 extern void SSD1306_scroll(bool on);
+extern void SSD1306_hscroll(int page0, int page1, bool left, uint8_t interval);
+extern void SSD1306_scroll_stop();
+extern void SSD1306_set_start_line(uint8_t line);
+extern void SSD1306_display_on(bool on);
 extern void render(uint8_t *buf, struct render_area *area);
+extern void render_dirty(uint8_t *buf);
+extern void render_frame(const uint8_t *frame);
+extern void SSD1306_dma_init();
+extern bool SSD1306_flush_poll();
+extern void SSD1306_flush_wait();
+extern void render_async(uint8_t *buf, struct render_area *area, ssd1306_flush_cb done);
 extern void SetPixel(uint8_t *buf, int x, int y, bool on);
 extern void DrawLine(uint8_t *buf, int x0, int y0, int x1, int y1, bool on);
+extern void BlitBitmap(uint8_t *buf, int x, int y, const uint8_t *bmp, int w, int h, enum ssd1306_blit_op op);
+extern void FillRect(uint8_t *buf, int x, int y, int w, int h, bool on);
+extern void InvertRect(uint8_t *buf, int x, int y, int w, int h);
 extern void WriteChar(uint8_t *buf, int16_t x, int16_t y, uint8_t ch);
-extern void WriteString(uint8_t *buf, int16_t x, int16_t y, char *str);
\ No newline at end of file
+extern void WriteString(uint8_t *buf, int16_t x, int16_t y, char *str);
+extern int WriteGlyph(uint8_t *buf, const ssd1306_font_t *font, int x, int y, uint32_t cp);
+extern int WriteStringFont(uint8_t *buf, const ssd1306_font_t *font, int x, int y, const char *str);
+extern int StringWidth(const ssd1306_font_t *font, const char *str);
+
+// The same driver for any panel, through a display handle. Panels on different
+// I2C controllers flush concurrently; panels sharing one take turns.
+extern void ssd1306_setup(ssd1306_t *d, struct i2c_inst *i2c, uint8_t addr, int width, int height, uint8_t *frame);
+extern void ssd1306_dma_init(ssd1306_t *d, uint16_t *flush_tx);
+extern void ssd1306_init(ssd1306_t *d);
+extern uint ssd1306_negotiate_clock(ssd1306_t *d);
+extern void ssd1306_reclock(ssd1306_t *d);
+extern void ssd1306_send_cmd(ssd1306_t *d, uint8_t cmd);
+extern void ssd1306_send_cmd_list(ssd1306_t *d, uint8_t *buf, int num);
+extern void ssd1306_mark_dirty(ssd1306_t *d, int x0, int x1, int page0, int page1);
+extern void ssd1306_clear_dirty(ssd1306_t *d);
+extern void ssd1306_hscroll(ssd1306_t *d, int page0, int page1, bool left, uint8_t interval);
+extern void ssd1306_scroll_stop(ssd1306_t *d);
+extern void ssd1306_set_start_line(ssd1306_t *d, uint8_t line);
+extern void ssd1306_display_on(ssd1306_t *d, bool on);
+extern void ssd1306_show(ssd1306_t *d);
+extern void ssd1306_show_dirty(ssd1306_t *d);
+extern void ssd1306_show_frame(ssd1306_t *d, const uint8_t *frame);
+extern void ssd1306_show_async(ssd1306_t *d, ssd1306_flush_cb done);
+extern bool ssd1306_flush_poll(ssd1306_t *d);
+extern void ssd1306_flush_wait(ssd1306_t *d);
+extern void ssd1306_set_pixel(ssd1306_t *d, int x, int y, bool on);
+extern void ssd1306_draw_line(ssd1306_t *d, int x0, int y0, int x1, int y1, bool on);
+extern void ssd1306_blit(ssd1306_t *d, int x, int y, const uint8_t *bmp, int w, int h, enum ssd1306_blit_op op);
+extern void ssd1306_fill_rect(ssd1306_t *d, int x, int y, int w, int h, bool on);
+extern void ssd1306_invert_rect(ssd1306_t *d, int x, int y, int w, int h);
+extern int ssd1306_write_glyph(ssd1306_t *d, const ssd1306_font_t *font, int x, int y, uint32_t cp);
+extern int ssd1306_write_string(ssd1306_t *d, const ssd1306_font_t *font, int x, int y, const char *str);
\ No newline at end of file
@@ -7,12 +7,53 @@
  #include <stdio.h>
  #include <string.h>
  #include <stdlib.h>
- #include <ctype.h>
  #include "pico/stdlib.h"
  #include "pico/binary_info.h"
  #include "hardware/i2c.h"
- #include "ssd1306_font.h"
+ #include "hardware/dma.h"
+ #include "ssd1306_fonts.h"
  #include "ssd1306_i2c.h"
+ #include "trace.h"
+ 
+ // Nothing on the render path may touch the heap, let the compiler enforce it
+ #pragma GCC poison malloc calloc realloc free
+ 
+ // The main display, driven by the functions without a handle argument. Its bus,
+ // address and geometry are the compile-time SSD1306_* constants, which also turn
+ // its strides and bounds into constants on the drawing paths.
+ static uint16_t main_flush_tx[SSD1306_FRAME_LEN];
+ static ssd1306_t main_disp = {
+     .i2c = i2c1,
+     .addr = SSD1306_I2C_ADDR,
+     .width = SSD1306_WIDTH,
+     .height = SSD1306_HEIGHT,
+     .pages = SSD1306_NUM_PAGES,
+     .scroll_page0 = 1,
+     .scroll_page1 = 0,
+     .dma_chan = -1,
+ };
+ 
+ // Display with a flush in flight on each I2C controller. Panels sharing a bus
+ // take turns; panels on different buses flush concurrently.
+ static ssd1306_t *bus_owner[2];
+ 
+ // Bus speed per I2C controller, as an index into clk_steps_khz; -1 while the
+ // application's own fixed rate is in use, which is never changed behind its back
+ static const uint16_t clk_steps_khz[] = SSD1306_I2C_CLK_STEPS;
+ static int8_t bus_clk_step[2] = {-1, -1};
+ 
+ void ssd1306_flush_wait(ssd1306_t *d);
+ 
+ // Geometry fast path: 128 column panels (all the common ones) get their stride as
+ // a constant, as the main display always does
+ #define WITH_WIDTH(d, call, ...) \
+   ((d)->width == 128 ? call(__VA_ARGS__, 128) : call(__VA_ARGS__, (d)->width))
+ 
+ static inline bool covers_panel(const ssd1306_t *d, const struct render_area *area)
+ {
+   return area->start_col == 0 && area->end_col == d->width - 1 &&
+          area->start_page == 0 && area->end_page == d->pages - 1;
+ }
  
  void calc_render_area_buflen(struct render_area *area)
  {
@@ -20,19 +61,122 @@
    area->buflen = (area->end_col - area->start_col + 1) * (area->end_page - area->start_page + 1);
  }
  
- void SSD1306_send_cmd(uint8_t cmd)
+ void ssd1306_setup(ssd1306_t *d, struct i2c_inst *i2c, uint8_t addr, int width, int height, uint8_t *frame)
  {
+   assert(width <= SSD1306_MAX_WIDTH && height <= (int)(SSD1306_MAX_PAGES * SSD1306_PAGE_HEIGHT) && height % 8 == 0);
+ 
+   memset(d, 0, sizeof(*d));
+   d->i2c = i2c;
+   d->addr = addr;
+   d->width = width;
+   d->height = height;
+   d->pages = height / SSD1306_PAGE_HEIGHT;
+   d->buf = frame ? frame + SSD1306_BUF_PREFIX : NULL;
+   d->scroll_page0 = 1;
+   d->dma_chan = -1;
+ }
+ 
+ // Waits until nothing else is using this display's bus
+ static void bus_wait(ssd1306_t *d)
+ {
+   ssd1306_t *owner;
+ 
+   while ((owner = bus_owner[i2c_hw_index(d->i2c)]))
+     ssd1306_flush_wait(owner);
+ }
+ 
+ static void set_clk_step(i2c_inst_t *i2c, int step)
+ {
+   bus_clk_step[i2c_hw_index(i2c)] = step;
+   i2c_set_baudrate(i2c, clk_steps_khz[step] * 1000);
+ }
+ 
+ // After a NAK or timeout on a negotiated bus, drop to the next slower speed.
+ // Returns false when there is nothing slower left to try.
+ static bool clk_fallback(i2c_inst_t *i2c)
+ {
+   int step = bus_clk_step[i2c_hw_index(i2c)];
+ 
+   if (step <= 0)
+     return false;
+   TRACE_COUNT(I2C_FALLBACK);
+   set_clk_step(i2c, step - 1);
+   return true;
+ }
+ 
+ // Twice the nominal time of a len byte write (9 clocks per byte, address
+ // included) plus a millisecond of slack; 100 kHz is assumed for a fixed rate
+ static uint32_t write_timeout_us(i2c_inst_t *i2c, int len)
+ {
+   int step = bus_clk_step[i2c_hw_index(i2c)];
+   uint32_t khz = step >= 0 ? clk_steps_khz[step] : 100;
+ 
+   return 2 * (len + 1) * 9 * 1000 / khz + 1000;
+ }
+ 
+ // Every blocking write goes through here, so a panel that stops keeping up
+ // costs one retry at a lower speed instead of a lost frame
+ static int bus_write(ssd1306_t *d, const uint8_t *src, int len)
+ {
+   int ret;
+ 
+   do
+     ret = i2c_write_timeout_us(d->i2c, d->addr, src, len, false, write_timeout_us(d->i2c, len));
+   while (ret != len && clk_fallback(d->i2c));
+   return ret;
+ }
+ 
+ void ssd1306_send_cmd(ssd1306_t *d, uint8_t cmd)
+ {
+   // never interleave with a DMA flush that is still using the bus
+   bus_wait(d);
+ 
    // I2C write process expects a control byte followed by data
    // this "data" can be a command or data to follow up a command
    // Co = 1, D/C = 0 => the driver expects a command
    uint8_t buf[2] = {0x80, cmd};
-   i2c_write_blocking(i2c1, SSD1306_I2C_ADDR, buf, 2, false);
+   bus_write(d, buf, 2);
+ }
+ 
+ void ssd1306_send_cmd_list(ssd1306_t *d, uint8_t *buf, int num)
+ {
+   // Co = 0, D/C = 0 => every byte after the control byte is a command, so the
+   // whole list goes out as one transaction instead of one per command byte
+   uint8_t stream[SSD1306_CMD_STREAM_MAX + 1];
+ 
+   bus_wait(d);
+ 
+   stream[0] = 0x00;
+   while (num > 0)
+   {
+     int n = num < SSD1306_CMD_STREAM_MAX ? num : SSD1306_CMD_STREAM_MAX;
+ 
+     memcpy(stream + 1, buf, n);
+     bus_write(d, stream, n + 1);
+     buf += n;
+     num -= n;
+   }
+ }
+ 
+ static void send_with_header(ssd1306_t *d, const uint8_t *hdr, int hdrlen, uint8_t buf[], int buflen)
+ {
+   // the header has to go out in the same transaction, just before the data.
+   // buf must start a frame: the SSD1306_BUF_PREFIX bytes in front of it are
+   // reserved for the header, so the frame is sent in place without a copy.
+   bus_wait(d);
+ 
+   memcpy(buf - hdrlen, hdr, hdrlen);
+   bus_write(d, buf - hdrlen, buflen + hdrlen);
+ }
+ 
+ void SSD1306_send_cmd(uint8_t cmd)
+ {
+   ssd1306_send_cmd(&main_disp, cmd);
  }
  
  void SSD1306_send_cmd_list(uint8_t *buf, int num)
  {
-   for (int i = 0; i < num; i++)
-     SSD1306_send_cmd(buf[i]);
+   ssd1306_send_cmd_list(&main_disp, buf, num);
  }
  
  void SSD1306_send_buf(uint8_t buf[], int buflen)
@@ -40,21 +184,99 @@
    // in horizontal addressing mode, the column address pointer auto-increments
    // and then wraps around to the next page, so we can send the entire frame
    // buffer in one gooooooo!
+   static const uint8_t data_ctrl = 0x40;
+   uint32_t t0 = TRACE_BEGIN();
  
-   // copy our frame buffer into a new buffer because we need to add the control byte
-   // to the beginning
+   send_with_header(&main_disp, &data_ctrl, 1, buf, buflen);
+   TRACE_END(SEND_BUF, t0);
+ }
  
-   uint8_t *temp_buf = malloc(buflen + 1);
+ static void build_window_header(uint8_t hdr[SSD1306_WINDOW_HDR_LEN], const struct render_area *area)
+ {
+   // Co = 1, D/C = 0 before each command byte keeps the controller reading control
+   // bytes, then a final Co = 0, D/C = 1 (0x40) turns the rest of the transaction
+   // into display data. This lets the address window ride along with the data.
+   const uint8_t cmds[] = {
+       SSD1306_SET_COL_ADDR,
+       area->start_col,
+       area->end_col,
+       SSD1306_SET_PAGE_ADDR,
+       area->start_page,
+       area->end_page};
  
-   temp_buf[0] = 0x40;
-   memcpy(temp_buf + 1, buf, buflen);
+   for (uint i = 0; i < count_of(cmds); i++)
+   {
+     hdr[2 * i] = 0x80;
+     hdr[2 * i + 1] = cmds[i];
+   }
+   hdr[SSD1306_WINDOW_HDR_LEN - 1] = 0x40;
+ }
  
-   i2c_write_blocking(i2c1, SSD1306_I2C_ADDR, temp_buf, buflen + 1, false);
+ // Damage tracking. For every page we keep the span of columns that changed since
+ // the last flush, as a half open interval [dirty_start, dirty_end). An empty span
+ // (start >= end) means the page is clean, so the zeroed initial state is all clean.
+ void ssd1306_mark_dirty(ssd1306_t *d, int x0, int x1, int page0, int page1)
+ {
+   // record columns x0..x1 (inclusive) on pages page0..page1 (inclusive) as modified
+   if (x0 < 0)
+     x0 = 0;
+   if (x1 > d->width - 1)
+     x1 = d->width - 1;
+   if (page0 < 0)
+     page0 = 0;
+   if (page1 > d->pages - 1)
+     page1 = d->pages - 1;
+   if (x0 > x1 || page0 > page1)
+     return;
  
-   free(temp_buf);
+   for (int page = page0; page <= page1; page++)
+   {
+     if (d->dirty_start[page] >= d->dirty_end[page])
+     {
+       d->dirty_start[page] = x0;
+       d->dirty_end[page] = x1 + 1;
+     }
+     else
+     {
+       if (x0 < d->dirty_start[page])
+         d->dirty_start[page] = x0;
+       if (x1 + 1 > d->dirty_end[page])
+         d->dirty_end[page] = x1 + 1;
+     }
+   }
  }
  
- void SSD1306_init()
+ // single column of one page, for callers that already know it is on the panel
+ static inline void mark_column(ssd1306_t *d, int x, int page)
+ {
+   if (d->dirty_start[page] >= d->dirty_end[page])
+   {
+     d->dirty_start[page] = x;
+     d->dirty_end[page] = x + 1;
+   }
+   else if (x < d->dirty_start[page])
+     d->dirty_start[page] = x;
+   else if (x >= d->dirty_end[page])
+     d->dirty_end[page] = x + 1;
+ }
+ 
+ void ssd1306_clear_dirty(ssd1306_t *d)
+ {
+   memset(d->dirty_start, 0, sizeof(d->dirty_start));
+   memset(d->dirty_end, 0, sizeof(d->dirty_end));
+ }
+ 
+ void SSD1306_mark_dirty(int x0, int x1, int page0, int page1)
+ {
+   ssd1306_mark_dirty(&main_disp, x0, x1, page0, page1);
+ }
+ 
+ void SSD1306_clear_dirty()
+ {
+   ssd1306_clear_dirty(&main_disp);
+ }
+ 
+ void ssd1306_init(ssd1306_t *d)
  {
    // Some of these commands are not strictly necessary as the reset
    // process defaults to some of these but they are shown here
@@ -70,19 +292,13 @@
        SSD1306_SET_DISP_START_LINE,    // set display start line to 0
        SSD1306_SET_SEG_REMAP | 0x01,   // set segment re-map, column address 127 is mapped to SEG0
        SSD1306_SET_MUX_RATIO,          // set multiplex ratio
-       SSD1306_HEIGHT - 1,             // Display height - 1
+       d->height - 1,                  // Display height - 1
        SSD1306_SET_COM_OUT_DIR | 0x08, // set COM (common) output scan direction. Scan from bottom up, COM[N-1] to COM0
        SSD1306_SET_DISP_OFFSET,        // set display offset
        0x00,                           // no offset
        SSD1306_SET_COM_PIN_CFG,        // set COM (common) pins hardware configuration. Board specific magic number.
                                        // 0x02 Works for 128x32, 0x12 Possibly works for 128x64. Other options 0x22, 0x32
- #if ((SSD1306_WIDTH == 128) && (SSD1306_HEIGHT == 32))
-       0x02,
- #elif ((SSD1306_WIDTH == 128) && (SSD1306_HEIGHT == 64))
-       0x12,
- #else
-       0x02,
- #endif
+       (d->width == 128 && d->height == 64) ? 0x12 : 0x02,
        /* timing and driving scheme */
        SSD1306_SET_DISP_CLK_DIV, // set display clock divide ratio
        0x80,                     // div ratio of 1, standard freq
@@ -101,58 +317,424 @@
        SSD1306_SET_DISP | 0x01,   // turn display on
    };
  
-   SSD1306_send_cmd_list(cmds, count_of(cmds));
+   ssd1306_send_cmd_list(d, cmds, count_of(cmds));
+   d->scroll_page0 = 1;
+   d->scroll_page1 = 0;
  }
  
- void SSD1306_scroll(bool on)
+ void SSD1306_init()
+ {
+   ssd1306_init(&main_disp);
+ }
+ 
+ uint ssd1306_negotiate_clock(ssd1306_t *d)
+ {
+   // The SSD1306 cannot be read back over I2C, so a speed passes when a burst of
+   // writes is ACKed in full and on time. NOP commands keep the probe harmless.
+   // A bus another panel already settled is never taken above its speed.
+   uint8_t probe[SSD1306_CMD_STREAM_MAX + 1];
+   int top = bus_clk_step[i2c_hw_index(d->i2c)];
+   int best = 0;
+ 
+   if (top < 0)
+     top = count_of(clk_steps_khz) - 1;
+ 
+   bus_wait(d);
+   memset(probe, SSD1306_NOP, sizeof(probe));
+   probe[0] = 0x00;
+ 
+   for (int step = 0; step <= top; step++)
+   {
+     bool ok = true;
+ 
+     set_clk_step(d->i2c, step);
+     for (int i = 0; i < SSD1306_I2C_PROBE_WRITES && ok; i++)
+       ok = i2c_write_timeout_us(d->i2c, d->addr, probe, sizeof(probe), false,
+                                 write_timeout_us(d->i2c, sizeof(probe))) == sizeof(probe);
+     if (!ok)
+       break;
+     best = step;
+   }
+ 
+   set_clk_step(d->i2c, best);
+   return clk_steps_khz[best];
+ }
+ 
+ uint SSD1306_negotiate_clock()
  {
-   // configure horizontal scrolling
+   return ssd1306_negotiate_clock(&main_disp);
+ }
+ 
+ void ssd1306_reclock(ssd1306_t *d)
+ {
+   // The SCL dividers are counted in clk_sys cycles, so after a clock change the
+   // bus runs at the wrong speed and the write timeouts no longer fit it. Put it
+   // back on its nominal speed; a fixed rate bus is assumed to use SSD1306_I2C_CLK.
+   int step = bus_clk_step[i2c_hw_index(d->i2c)];
+ 
+   bus_wait(d);
+   i2c_set_baudrate(d->i2c, (step >= 0 ? clk_steps_khz[step] : SSD1306_I2C_CLK) * 1000);
+ }
+ 
+ void SSD1306_reclock()
+ {
+   ssd1306_reclock(&main_disp);
+ }
+ 
+ void ssd1306_scroll_stop(ssd1306_t *d)
+ {
+   if (d->scroll_page0 > d->scroll_page1)
+     return;
+ 
+   // The scrolled RAM is left rotated by an unknown amount, so the pages must be
+   // sent again before they show the frame buffer content
+   ssd1306_send_cmd(d, SSD1306_SET_SCROLL | 0x00);
+   ssd1306_mark_dirty(d, 0, d->width - 1, d->scroll_page0, d->scroll_page1);
+   d->scroll_page0 = 1;
+   d->scroll_page1 = 0;
+ }
+ 
+ void ssd1306_hscroll(ssd1306_t *d, int page0, int page1, bool left, uint8_t interval)
+ {
+   // The controller rotates pages page0..page1 of its RAM by one column every
+   // interval, with no further bus traffic. Content wider than the panel cannot
+   // be scrolled this way, since it never is in the RAM as a whole.
+   ssd1306_scroll_stop(d);
+ 
    uint8_t cmds[] = {
-       SSD1306_SET_HORIZ_SCROLL | 0x00,
-       0x00,                                // dummy byte
-       0x00,                                // start page 0
-       0x00,                                // time interval
-       0x03,                                // end page 3 SSD1306_NUM_PAGES ??
-       0x00,                                // dummy byte
-       0xFF,                                // dummy byte
-       SSD1306_SET_SCROLL | (on ? 0x01 : 0) // Start/stop scrolling
+       SSD1306_SET_HORIZ_SCROLL | (left ? 0x01 : 0x00),
+       0x00,     // dummy byte
+       page0,    // start page
+       interval, // time interval
+       page1,    // end page
+       0x00,     // dummy byte
+       0xFF,     // dummy byte
+       SSD1306_SET_SCROLL | 0x01 // start scrolling
    };
  
-   SSD1306_send_cmd_list(cmds, count_of(cmds));
+   ssd1306_send_cmd_list(d, cmds, count_of(cmds));
+   d->scroll_page0 = page0;
+   d->scroll_page1 = page1;
+ }
+ 
+ void ssd1306_set_start_line(ssd1306_t *d, uint8_t line)
+ {
+   // vertical scrolling: the panel shows RAM rows line..line+height-1, wrapping at 64
+   ssd1306_send_cmd(d, SSD1306_SET_DISP_START_LINE | (line % SSD1306_RAM_LINES));
+ }
+ 
+ void ssd1306_display_on(ssd1306_t *d, bool on)
+ {
+   // sleep mode keeps the RAM; the charge pump is only needed while the panel is lit
+   uint8_t off[] = {SSD1306_SET_DISP | 0x00, SSD1306_SET_CHARGE_PUMP, 0x10};
+   uint8_t lit[] = {SSD1306_SET_CHARGE_PUMP, 0x14, SSD1306_SET_DISP | 0x01};
+ 
+   if (on)
+     ssd1306_send_cmd_list(d, lit, count_of(lit));
+   else
+     ssd1306_send_cmd_list(d, off, count_of(off));
+ }
+ 
+ void SSD1306_scroll(bool on)
+ {
+   // scroll the whole panel right, one column every 5 frames
+   if (on)
+     ssd1306_hscroll(&main_disp, 0, SSD1306_NUM_PAGES - 1, false, SSD1306_SCROLL_5_FRAMES);
+   else
+     ssd1306_scroll_stop(&main_disp);
+ }
+ 
+ void SSD1306_hscroll(int page0, int page1, bool left, uint8_t interval)
+ {
+   ssd1306_hscroll(&main_disp, page0, page1, left, interval);
+ }
+ 
+ void SSD1306_scroll_stop()
+ {
+   ssd1306_scroll_stop(&main_disp);
+ }
+ 
+ void SSD1306_set_start_line(uint8_t line)
+ {
+   ssd1306_set_start_line(&main_disp, line);
+ }
+ void SSD1306_display_on(bool on)
+ {
+   ssd1306_display_on(&main_disp, on);
+ }
+ 
+ static void render_area(ssd1306_t *d, uint8_t *buf, struct render_area *area)
+ {
+   // update a portion of the display with a render area, window and data in one transaction
+   uint8_t hdr[SSD1306_WINDOW_HDR_LEN];
+   uint32_t t0 = TRACE_BEGIN();
+ 
+   ssd1306_scroll_stop(d); // RAM writes during a horizontal scroll get corrupted
+   build_window_header(hdr, area);
+   send_with_header(d, hdr, SSD1306_WINDOW_HDR_LEN, buf, area->buflen);
+   TRACE_END(RENDER, t0);
+ 
+   // a full frame push leaves nothing pending on the panel
+   if (covers_panel(d, area))
+     ssd1306_clear_dirty(d);
+ }
+ 
+ static void render_span(ssd1306_t *d, const uint8_t *src, const struct render_area *area)
+ {
+   // A span inside the frame has live pixels in front of it, not a free prefix,
+   // so it is staged after its header in a scratch buffer (one page at most)
+   static uint8_t span_tx[SSD1306_WINDOW_HDR_LEN + SSD1306_MAX_WIDTH];
+   uint32_t t0 = TRACE_BEGIN();
+ 
+   assert(area->start_page == area->end_page);
+   bus_wait(d);
+ 
+   build_window_header(span_tx, area);
+   memcpy(span_tx + SSD1306_WINDOW_HDR_LEN, src, area->buflen);
+   bus_write(d, span_tx, SSD1306_WINDOW_HDR_LEN + area->buflen);
+   TRACE_END(RENDER, t0);
+ }
+ 
+ static inline void render_dirty_impl(ssd1306_t *d, uint8_t *buf, int width)
+ {
+   // Flush only the modified column span of every dirty page. In horizontal
+   // addressing mode a single page span is contiguous in the frame buffer, so
+   // each one goes out as its own small render area.
+   uint32_t t0 = TRACE_BEGIN();
+ 
+   ssd1306_scroll_stop(d);
+   for (int page = 0; page < d->pages; page++)
+   {
+     if (d->dirty_start[page] >= d->dirty_end[page])
+       continue;
+ 
+     struct render_area area = {
+         .start_col = d->dirty_start[page],
+         .end_col = d->dirty_end[page] - 1,
+         .start_page = page,
+         .end_page = page};
+     calc_render_area_buflen(&area);
+ 
+     d->dirty_start[page] = d->dirty_end[page] = 0;
+     render_span(d, buf + page * width + area.start_col, &area);
+   }
+   TRACE_END(RENDER_DIRTY, t0);
  }
  
  void render(uint8_t *buf, struct render_area *area)
  {
-   // update a portion of the display with a render area
-   uint8_t cmds[] = {
-       SSD1306_SET_COL_ADDR,
-       area->start_col,
-       area->end_col,
-       SSD1306_SET_PAGE_ADDR,
-       area->start_page,
-       area->end_page};
+   render_area(&main_disp, buf, area);
+ }
+ 
+ void render_dirty(uint8_t *buf)
+ {
+   render_dirty_impl(&main_disp, buf, SSD1306_WIDTH);
+ }
+ 
+ void ssd1306_show(ssd1306_t *d)
+ {
+   struct render_area area = {.start_col = 0, .end_col = d->width - 1, .start_page = 0, .end_page = d->pages - 1};
  
-   SSD1306_send_cmd_list(cmds, count_of(cmds));
-   SSD1306_send_buf(buf, area->buflen);
+   calc_render_area_buflen(&area);
+   render_area(d, d->buf, &area);
  }
  
- void SetPixel(uint8_t *buf, int x, int y, bool on)
+ void ssd1306_show_dirty(ssd1306_t *d)
  {
-   assert(x >= 0 && x < SSD1306_WIDTH && y >= 0 && y < SSD1306_HEIGHT);
+   WITH_WIDTH(d, render_dirty_impl, d, d->buf);
+ }
+ 
+ void ssd1306_show_frame(ssd1306_t *d, const uint8_t *frame)
+ {
+   // Push a whole panel frame that carries its own window header (see
+   // SSD1306_FRAME_HDR), typically a const screen in flash. The I2C controller
+   // reads it straight from XIP: nothing is copied and d->buf is left alone, so
+   // it no longer matches the panel until the caller redraws or reloads it.
+   uint32_t t0 = TRACE_BEGIN();
+ 
+   assert(frame[0] == 0x80 && frame[SSD1306_WINDOW_HDR_LEN - 1] == 0x40);
+   bus_wait(d);
+   ssd1306_scroll_stop(d);
+   bus_write(d, frame, SSD1306_WINDOW_HDR_LEN + d->width * d->pages);
+   TRACE_END(RENDER_FRAME, t0);
+ 
+   ssd1306_clear_dirty(d);
+ }
+ 
+ void render_frame(const uint8_t *frame)
+ {
+   ssd1306_show_frame(&main_disp, frame);
+ }
+ 
+ // Asynchronous flushes. The address window and frame are expanded into 16 bit
+ // IC_DATA_CMD words (the byte, plus the STOP flag on the last one) so DMA can feed
+ // the I2C TX FIFO directly. This staging copy doubles as the back buffer: the caller may draw the
+ // next frame into its own buffer as soon as the flush has started.
+ void ssd1306_dma_init(ssd1306_t *d, uint16_t *flush_tx)
+ {
+   // Claim a channel for asynchronous flushes. Without one, the async calls
+   // quietly fall back to the blocking path.
+   d->flush_tx = flush_tx;
+   d->dma_chan = flush_tx ? dma_claim_unused_channel(false) : -1;
+   if (d->dma_chan >= 0)
+     i2c_get_hw(d->i2c)->dma_cr = I2C_IC_DMA_CR_TDMAE_BITS;
+ }
+ 
+ void SSD1306_dma_init()
+ {
+   ssd1306_dma_init(&main_disp, main_flush_tx);
+ }
+ 
+ static void flush_finish(ssd1306_t *d, bool ok)
+ {
+   ssd1306_flush_cb cb = d->flush_cb;
+ 
+   TRACE_END(RENDER_ASYNC, d->flush_t0);
+   d->flush_cb = NULL;
+   d->flush_busy = false;
+   bus_owner[i2c_hw_index(d->i2c)] = NULL;
+   if (cb)
+     cb(ok);
+ }
+ 
+ static void flush_start(ssd1306_t *d)
+ {
+   i2c_hw_t *hw = i2c_get_hw(d->i2c);
+ 
+   d->flush_deadline_us = time_us_32() + write_timeout_us(d->i2c, d->flush_len);
+ 
+   dma_channel_config c = dma_channel_get_default_config(d->dma_chan);
+   channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+   channel_config_set_read_increment(&c, true);
+   channel_config_set_write_increment(&c, false);
+   channel_config_set_dreq(&c, i2c_get_dreq(d->i2c, true));
+   dma_channel_configure(d->dma_chan, &c, &hw->data_cmd, d->flush_tx, d->flush_len, true);
+ }
+ 
+ bool ssd1306_flush_poll(ssd1306_t *d)
+ {
+   // advance the asynchronous flush, returns true when the bus is free again
+   if (!d->flush_busy)
+     return true;
+ 
+   i2c_hw_t *hw = i2c_get_hw(d->i2c);
+ 
+   if (hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS)
+   {
+     // NAK or arbitration loss, the controller flushed its FIFO so stop feeding it
+     dma_channel_abort(d->dma_chan);
+     (void)hw->clr_tx_abrt;
+ 
+     // the staging buffer still holds the whole transaction, resend it slower
+     if (clk_fallback(d->i2c))
+     {
+       flush_start(d);
+       return false;
+     }
+     flush_finish(d, false);
+     return !d->flush_busy;
+   }
+ 
+   if ((int32_t)(time_us_32() - d->flush_deadline_us) > 0)
+   {
+     // stuck: make the controller give up, which surfaces as an abort above
+     hw->enable |= I2C_IC_ENABLE_ABORT_BITS;
+     d->flush_deadline_us = time_us_32() + write_timeout_us(d->i2c, d->flush_len);
+     return false;
+   }
+ 
+   // the DMA finishing only means the last word reached the FIFO, wait for the STOP too
+   if (dma_channel_is_busy(d->dma_chan) ||
+       !(hw->status & I2C_IC_STATUS_TFE_BITS) ||
+       (hw->status & I2C_IC_STATUS_MST_ACTIVITY_BITS))
+     return false;
+ 
+   flush_finish(d, true);
+   return !d->flush_busy;
+ }
+ 
+ void ssd1306_flush_wait(ssd1306_t *d)
+ {
+   // a completion callback may chain another flush, so keep going until truly idle
+   while (d->flush_busy)
+     ssd1306_flush_poll(d);
+ }
+ 
+ bool SSD1306_flush_poll()
+ {
+   return ssd1306_flush_poll(&main_disp);
+ }
+ 
+ void SSD1306_flush_wait()
+ {
+   ssd1306_flush_wait(&main_disp);
+ }
+ 
+ static void render_area_async(ssd1306_t *d, uint8_t *buf, struct render_area *area, ssd1306_flush_cb done)
+ {
+   // same as render(), but the data phase runs from DMA and this returns immediately
+   if (d->dma_chan < 0)
+   {
+     render_area(d, buf, area);
+     if (done)
+       done(true);
+     return;
+   }
+ 
+   uint8_t hdr[SSD1306_WINDOW_HDR_LEN];
+   int len = SSD1306_WINDOW_HDR_LEN + area->buflen;
+ 
+   ssd1306_scroll_stop(d);
+   bus_wait(d);
+ 
+   build_window_header(hdr, area);
+   for (int i = 0; i < SSD1306_WINDOW_HDR_LEN; i++)
+     d->flush_tx[i] = hdr[i];
+   for (int i = 0; i < area->buflen; i++)
+     d->flush_tx[SSD1306_WINDOW_HDR_LEN + i] = buf[i];
+   d->flush_tx[len - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+ 
+   i2c_hw_t *hw = i2c_get_hw(d->i2c);
+   hw->enable = 0;
+   hw->tar = d->addr;
+   hw->enable = 1;
+ 
+   d->flush_cb = done;
+   d->flush_busy = true;
+   d->flush_len = len;
+   d->flush_t0 = TRACE_BEGIN();
+   bus_owner[i2c_hw_index(d->i2c)] = d;
+   flush_start(d);
+ 
+   if (covers_panel(d, area))
+     ssd1306_clear_dirty(d);
+ }
+ 
+ void render_async(uint8_t *buf, struct render_area *area, ssd1306_flush_cb done)
+ {
+   render_area_async(&main_disp, buf, area, done);
+ }
+ 
+ void ssd1306_show_async(ssd1306_t *d, ssd1306_flush_cb done)
+ {
+   struct render_area area = {.start_col = 0, .end_col = d->width - 1, .start_page = 0, .end_page = d->pages - 1};
+ 
+   calc_render_area_buflen(&area);
+   render_area_async(d, d->buf, &area, done);
+ }
+ 
+ static inline void pixel_impl(ssd1306_t *d, uint8_t *buf, int x, int y, bool on, int width)
+ {
+   assert(x >= 0 && x < width && y >= 0 && y < d->height);
  
    // The calculation to determine the correct bit to set depends on which address
    // mode we are in. This code assumes horizontal
  
    // The video ram on the SSD1306 is split up in to 8 rows, one bit per pixel.
-   // Each row is 128 long by 8 pixels high, each byte vertically arranged, so byte 0 is x=0, y=0->7,
+   // Each row is width long by 8 pixels high, each byte vertically arranged, so byte 0 is x=0, y=0->7,
    // byte 1 is x = 1, y=0->7 etc
  
-   // This code could be optimised, but is like this for clarity. The compiler
-   // should do a half decent job optimising it anyway.
- 
-   const int BytesPerRow = SSD1306_WIDTH; // x pixels, 1bpp, but each row is 8 pixel high, so (x / 8) * 8
- 
-   int byte_idx = (y / 8) * BytesPerRow + x;
+   int byte_idx = (y / 8) * width + x;
    uint8_t byte = buf[byte_idx];
  
    if (on)
@@ -160,10 +742,26 @@
    else
      byte &= ~(1 << (y % 8));
  
-   buf[byte_idx] = byte;
+   // only damage the page when the pixel actually changed
+   if (byte != buf[byte_idx])
+   {
+     buf[byte_idx] = byte;
+     mark_column(d, x, y / 8);
+   }
  }
+ 
+ void SetPixel(uint8_t *buf, int x, int y, bool on)
+ {
+   pixel_impl(&main_disp, buf, x, y, on, SSD1306_WIDTH);
+ }
+ 
+ void ssd1306_set_pixel(ssd1306_t *d, int x, int y, bool on)
+ {
+   WITH_WIDTH(d, pixel_impl, d, d->buf, x, y, on);
+ }
+ 
  // Basic Bresenhams.
- void DrawLine(uint8_t *buf, int x0, int y0, int x1, int y1, bool on)
+ static void line_impl(ssd1306_t *d, uint8_t *buf, int x0, int y0, int x1, int y1, bool on, int width)
  {
  
    int dx = abs(x1 - x0);
@@ -175,7 +773,7 @@
  
    while (true)
    {
-     SetPixel(buf, x0, y0, on);
+     pixel_impl(d, buf, x0, y0, on, width);
      if (x0 == x1 && y0 == y1)
        break;
      e2 = 2 * err;
@@ -193,47 +791,290 @@
    }
  }
  
- inline int GetFontIndex(uint8_t ch)
+ void DrawLine(uint8_t *buf, int x0, int y0, int x1, int y1, bool on)
+ {
+   line_impl(&main_disp, buf, x0, y0, x1, y1, on, SSD1306_WIDTH);
+ }
+ 
+ void ssd1306_draw_line(ssd1306_t *d, int x0, int y0, int x1, int y1, bool on)
+ {
+   WITH_WIDTH(d, line_impl, d, d->buf, x0, y0, x1, y1, on);
+ }
+ 
+ // Frame buffer words for the 32-bit paths; may alias the byte buffer
+ typedef uint32_t __attribute__((may_alias)) fb_word;
+ 
+ static inline uint32_t blend(uint32_t dst, uint32_t src, uint32_t mask, enum ssd1306_blit_op op)
  {
-   if (ch >= 'A' && ch <= 'Z')
+   switch (op)
    {
-     return ch - 'A' + 1;
+   case SSD1306_BLIT_COPY:
+     return (dst & ~mask) | (src & mask);
+   case SSD1306_BLIT_OR:
+     return dst | (src & mask);
+   case SSD1306_BLIT_CLEAR:
+     return dst & ~(src & mask);
+   default:
+     return dst ^ (src & mask);
    }
-   else if (ch >= '0' && ch <= '9')
+ }
+ 
+ // Applies a solid row mask to n consecutive columns of one page, a word at a
+ // time once p is aligned. Returns true if any byte changed.
+ static inline bool span_op(uint8_t *p, int n, uint8_t mask, enum ssd1306_blit_op op)
+ {
+   uint32_t diff = 0;
+ 
+   for (; n > 0 && ((uintptr_t)p & 3); n--, p++)
    {
-     return ch - '0' + 27;
+     uint8_t v = blend(*p, 0xFF, mask, op);
+     diff |= *p ^ v;
+     *p = v;
    }
-   else
-     return 0; // Not got that char so space.
+ 
+   uint32_t mask32 = mask * 0x01010101u;
+   for (; n >= 4; n -= 4, p += 4)
+   {
+     fb_word *w = (fb_word *)p;
+     uint32_t v = blend(*w, 0xFFFFFFFFu, mask32, op);
+     diff |= *w ^ v;
+     *w = v;
+   }
+ 
+   for (; n > 0; n--, p++)
+   {
+     uint8_t v = blend(*p, 0xFF, mask, op);
+     diff |= *p ^ v;
+     *p = v;
+   }
+   return diff != 0;
  }
  
- void WriteChar(uint8_t *buf, int16_t x, int16_t y, uint8_t ch)
+ static inline void rect_op(ssd1306_t *d, uint8_t *buf, int x, int y, int w, int h, enum ssd1306_blit_op op, int width)
  {
-   if (x > SSD1306_WIDTH - 8 || y > SSD1306_HEIGHT - 8)
+   // clip once, then work a page at a time with a row mask for partial pages
+   int x0 = x < 0 ? 0 : x;
+   int x1 = x + w > width ? width : x + w;
+   int y0 = y < 0 ? 0 : y;
+   int y1 = y + h > d->height ? d->height : y + h;
+   if (x0 >= x1 || y0 >= y1)
      return;
  
-   // For the moment, only write on Y row boundaries (every 8 vertical pixels)
-   y = y / 8;
+   for (int page = y0 / 8; page <= (y1 - 1) / 8; page++)
+   {
+     int top = page * 8;
+     uint8_t mask = 0xFF;
+     if (y0 > top)
+       mask &= 0xFF << (y0 - top);
+     if (y1 < top + 8)
+       mask &= 0xFF >> (top + 8 - y1);
  
-   ch = toupper(ch);
-   int idx = GetFontIndex(ch);
-   int fb_idx = y * 128 + x;
+     if (span_op(buf + page * width + x0, x1 - x0, mask, op))
+       ssd1306_mark_dirty(d, x0, x1 - 1, page, page);
+   }
+ }
  
-   for (int i = 0; i < 8; i++)
+ void FillRect(uint8_t *buf, int x, int y, int w, int h, bool on)
+ {
+   rect_op(&main_disp, buf, x, y, w, h, on ? SSD1306_BLIT_OR : SSD1306_BLIT_CLEAR, SSD1306_WIDTH);
+ }
+ 
+ void InvertRect(uint8_t *buf, int x, int y, int w, int h)
+ {
+   rect_op(&main_disp, buf, x, y, w, h, SSD1306_BLIT_XOR, SSD1306_WIDTH);
+ }
+ 
+ void ssd1306_fill_rect(ssd1306_t *d, int x, int y, int w, int h, bool on)
+ {
+   WITH_WIDTH(d, rect_op, d, d->buf, x, y, w, h, on ? SSD1306_BLIT_OR : SSD1306_BLIT_CLEAR);
+ }
+ 
+ void ssd1306_invert_rect(ssd1306_t *d, int x, int y, int w, int h)
+ {
+   WITH_WIDTH(d, rect_op, d, d->buf, x, y, w, h, SSD1306_BLIT_XOR);
+ }
+ 
+ // Draws a w x h bitmap with its top left corner at (x, y). Each source page
+ // lands shifted by y % 8 across two display pages; the visible column range is
+ // computed once, so nothing is checked per pixel.
+ static void blit_impl(ssd1306_t *d, uint8_t *buf, int x, int y, const uint8_t *bmp, int w, int h,
+                       enum ssd1306_blit_op op, int width)
+ {
+   int cx0 = x < 0 ? -x : 0;
+   int cx1 = x + w > width ? width - x : w;
+   if (cx0 >= cx1 || h <= 0 || y >= d->height || y + h <= 0)
+     return;
+ 
+   int src_pages = (h + 7) / 8;
+   int page = y >= 0 ? y / 8 : -((7 - y) / 8); // floor(y / 8)
+   int shift = y - page * 8;
+ 
+   for (int sp = 0; sp < src_pages; sp++)
+   {
+     const uint8_t *src = bmp + sp * w;
+     uint8_t rows = sp == src_pages - 1 ? 0xFF >> (src_pages * 8 - h) : 0xFF;
+ 
+     // the upper part of the source page, then the part that spills into the next
+     for (int half = 0; half < 2; half++)
+     {
+       int dp = page + sp + half;
+       uint8_t mask = half ? (shift ? rows >> (8 - shift) : 0) : (uint8_t)(rows << shift);
+       if (dp < 0 || dp >= d->pages || !mask)
+         continue;
+ 
+       uint8_t *dst = buf + dp * width;
+       int first = -1, last = -1;
+       for (int c = cx0; c < cx1; c++)
+       {
+         uint8_t bits = half ? src[c] >> (8 - shift) : src[c] << shift;
+         uint8_t v = blend(dst[x + c], bits, mask, op);
+         if (v != dst[x + c])
+         {
+           dst[x + c] = v;
+           if (first < 0)
+             first = c;
+           last = c;
+         }
+       }
+ 
+       if (first >= 0)
+         ssd1306_mark_dirty(d, x + first, x + last, dp, dp);
+     }
+   }
+ }
+ 
+ void BlitBitmap(uint8_t *buf, int x, int y, const uint8_t *bmp, int w, int h, enum ssd1306_blit_op op)
+ {
+   blit_impl(&main_disp, buf, x, y, bmp, w, h, op, SSD1306_WIDTH);
+ }
+ 
+ void ssd1306_blit(ssd1306_t *d, int x, int y, const uint8_t *bmp, int w, int h, enum ssd1306_blit_op op)
+ {
+   WITH_WIDTH(d, blit_impl, d, d->buf, x, y, bmp, w, h, op);
+ }
+ 
+ // Constant time: one table read for the index, one more for proportional widths.
+ // Lower case maps to the capitals inside the table, and anything the font
+ // lacks (or beyond Latin-1) to the blank glyph.
+ static inline const uint8_t *GetGlyph(const ssd1306_font_t *font, uint32_t cp, int *width)
+ {
+   uint8_t idx = cp <= 0xFF ? font->map[cp] : 0;
+ 
+   if (!font->offset)
    {
-     buf[fb_idx++] = font[idx * 8 + i];
+     *width = font->width;
+     return font->bitmap + idx * font->width;
    }
+   *width = font->offset[idx + 1] - font->offset[idx];
+   return font->bitmap + font->offset[idx];
  }
  
+ // Decodes one UTF-8 sequence and advances *str past it. A byte that does not
+ // start a valid sequence is taken as Latin-1, so both encodings display.
+ static uint32_t NextCodepoint(const char **str)
+ {
+   const uint8_t *s = (const uint8_t *)*str;
+   uint32_t cp = s[0];
+   int len = 1;
+ 
+   if (cp >= 0xC2 && cp <= 0xDF && (s[1] & 0xC0) == 0x80)
+   {
+     cp = ((cp & 0x1F) << 6) | (s[1] & 0x3F);
+     len = 2;
+   }
+   else if (cp >= 0xE0 && cp <= 0xEF && (s[1] & 0xC0) == 0x80 && (s[2] & 0xC0) == 0x80)
+   {
+     cp = ((cp & 0x0F) << 12) | ((s[1] & 0x3F) << 6) | (s[2] & 0x3F);
+     len = 3;
+   }
+   else if (cp >= 0xF0 && cp <= 0xF4 && (s[1] & 0xC0) == 0x80 && (s[2] & 0xC0) == 0x80 && (s[3] & 0xC0) == 0x80)
+   {
+     cp = ((cp & 0x07) << 18) | ((s[1] & 0x3F) << 12) | ((s[2] & 0x3F) << 6) | (s[3] & 0x3F);
+     len = 4;
+   }
+ 
+   *str += len;
+   return cp;
+ }
+ 
+ // Draws one glyph at any (x, y), clipped to the screen, and returns the advance.
+ // The glyph cell and its spacing are overwritten, so text can be redrawn in place.
+ static inline int glyph_impl(ssd1306_t *d, uint8_t *buf, const ssd1306_font_t *font, int x, int y, uint32_t cp, int width)
+ {
+   int w;
+   const uint8_t *cols = GetGlyph(font, cp, &w);
+ 
+   blit_impl(d, buf, x, y, cols, w, font->height, SSD1306_BLIT_COPY, width);
+   if (font->spacing)
+     rect_op(d, buf, x + w, y, font->spacing, font->height, SSD1306_BLIT_CLEAR, width);
+   return w + font->spacing;
+ }
+ 
+ static int string_impl(ssd1306_t *d, uint8_t *buf, const ssd1306_font_t *font, int x, int y, const char *str, int width)
+ {
+   int x0 = x;
+ 
+   while (*str && x < width)
+     x += glyph_impl(d, buf, font, x, y, NextCodepoint(&str), width);
+   return x - x0;
+ }
+ 
+ int WriteGlyph(uint8_t *buf, const ssd1306_font_t *font, int x, int y, uint32_t cp)
+ {
+   return glyph_impl(&main_disp, buf, font, x, y, cp, SSD1306_WIDTH);
+ }
+ 
+ int WriteStringFont(uint8_t *buf, const ssd1306_font_t *font, int x, int y, const char *str)
+ {
+   return string_impl(&main_disp, buf, font, x, y, str, SSD1306_WIDTH);
+ }
+ 
+ int ssd1306_write_glyph(ssd1306_t *d, const ssd1306_font_t *font, int x, int y, uint32_t cp)
+ {
+   return WITH_WIDTH(d, glyph_impl, d, d->buf, font, x, y, cp);
+ }
+ 
+ int ssd1306_write_string(ssd1306_t *d, const ssd1306_font_t *font, int x, int y, const char *str)
+ {
+   return WITH_WIDTH(d, string_impl, d, d->buf, font, x, y, str);
+ }
+ 
+ int StringWidth(const ssd1306_font_t *font, const char *str)
+ {
+   int width = 0, w;
+ 
+   while (*str)
+   {
+     GetGlyph(font, NextCodepoint(&str), &w);
+     width += w + font->spacing;
+   }
+   return width;
+ }
+ 
+ // ch is a Latin-1 code point
+ void WriteChar(uint8_t *buf, int16_t x, int16_t y, uint8_t ch)
+ {
+   if (x > SSD1306_WIDTH - 8 || y > SSD1306_HEIGHT - 8)
+     return;
+ 
+   // Any Y works: the glyph cell is copied across two pages when unaligned. Only
+   // changed columns are marked, so rewriting identical text costs no bus time.
+   WriteGlyph(buf, &ssd1306_font_8x8, x, y, ch);
+ }
+ 
+ // str is UTF-8; each character takes one 8 pixel cell
  void WriteString(uint8_t *buf, int16_t x, int16_t y, char *str)
  {
    // Cull out any string off the screen
    if (x > SSD1306_WIDTH - 8 || y > SSD1306_HEIGHT - 8)
      return;
  
-   while (*str)
+   const char *s = str;
+   while (*s)
    {
-     WriteChar(buf, x, y, *str++);
+     uint32_t cp = NextCodepoint(&s);
+     if (x <= SSD1306_WIDTH - 8)
+       WriteGlyph(buf, &ssd1306_font_8x8, x, y, cp);
      x += 8;
    }
  }
\ No newline at end of file
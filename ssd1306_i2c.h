@@ -39,12 +39,24 @@ All text above, and the splash screen must be included in any redistribution
 #define SSD1306_I2C_CLK 400
 // #define SSD1306_I2C_CLK             1000
 
+// Rather than picking one, SSD1306_negotiate_clock() can climb these speeds (kHz,
+// slowest first) and keep the fastest one the panel ACKs reliably. The RP2040 is
+// specified up to 1000; beyond that it comes down to the module and its pull-ups.
+// A negotiated bus also steps back down by itself after a NAK or a timeout.
+// Call SSD1306_reclock() after changing clk_sys: the bus dividers derive from it.
+#ifndef SSD1306_I2C_CLK_AUTO
+#define SSD1306_I2C_CLK_AUTO 1
+#endif
+#define SSD1306_I2C_CLK_STEPS {400, 1000, 1400, 1800}
+#define SSD1306_I2C_PROBE_WRITES 8 // 33 byte writes that must all succeed at a speed
+
 // commands (see datasheet)
 #define SSD1306_SET_MEM_MODE _u(0x20)
 #define SSD1306_SET_COL_ADDR _u(0x21)
 #define SSD1306_SET_PAGE_ADDR _u(0x22)
 #define SSD1306_SET_HORIZ_SCROLL _u(0x26)
 #define SSD1306_SET_SCROLL _u(0x2E)
+#define SSD1306_SET_VERT_SCROLL_AREA _u(0xA3)
 
 #define SSD1306_SET_DISP_START_LINE _u(0x40)
 
@@ -66,11 +78,53 @@ All text above, and the splash screen must be included in any redistribution
 #define SSD1306_SET_PRECHARGE _u(0xD9)
 #define SSD1306_SET_COM_PIN_CFG _u(0xDA)
 #define SSD1306_SET_VCOM_DESEL _u(0xDB)
+#define SSD1306_NOP _u(0xE3)
 
 #define SSD1306_PAGE_HEIGHT _u(8)
 #define SSD1306_NUM_PAGES (SSD1306_HEIGHT / SSD1306_PAGE_HEIGHT)
 #define SSD1306_BUF_LEN (SSD1306_NUM_PAGES * SSD1306_WIDTH)
 
+// The controller has 64 rows of display RAM whatever the panel height; the rows
+// below the panel can be brought into view with SSD1306_set_start_line().
+#define SSD1306_RAM_PAGES _u(8)
+#define SSD1306_RAM_LINES (SSD1306_RAM_PAGES * SSD1306_PAGE_HEIGHT)
+
+// Horizontal scroll step interval, in frames (about 5.7 ms each with the clock
+// set by SSD1306_init)
+#define SSD1306_SCROLL_2_FRAMES _u(0x07)
+#define SSD1306_SCROLL_3_FRAMES _u(0x04)
+#define SSD1306_SCROLL_4_FRAMES _u(0x05)
+#define SSD1306_SCROLL_5_FRAMES _u(0x00)
+#define SSD1306_SCROLL_25_FRAMES _u(0x06)
+#define SSD1306_SCROLL_64_FRAMES _u(0x01)
+#define SSD1306_SCROLL_128_FRAMES _u(0x02)
+#define SSD1306_SCROLL_256_FRAMES _u(0x03)
+
+// render() sends the column/page address window in the same transaction as the
+// data: six commands each preceded by a 0x80 control byte, then the 0x40 one.
+#define SSD1306_WINDOW_HDR_LEN 13
+
+// Frame buffers passed to the driver must keep this many spare bytes in front of
+// the pixel data, where the window header is written when flushing.
+// Allocate SSD1306_FRAME_LEN bytes and draw from offset SSD1306_BUF_PREFIX.
+#define SSD1306_BUF_PREFIX SSD1306_WINDOW_HDR_LEN
+#define SSD1306_FRAME_LEN_FOR(width, height) (SSD1306_BUF_PREFIX + (height) / SSD1306_PAGE_HEIGHT * (width))
+#define SSD1306_FRAME_LEN SSD1306_FRAME_LEN_FOR(SSD1306_WIDTH, SSD1306_HEIGHT)
+
+// Window header of a whole panel, as the first SSD1306_WINDOW_HDR_LEN bytes of a
+// const frame. Frames built this way (tools/screengen.py) are sent by
+// render_frame() straight from flash, with no copy and no header to write.
+#define SSD1306_FRAME_HDR(width, pages) \
+  0x80, SSD1306_SET_COL_ADDR, 0x80, 0, 0x80, (width) - 1, \
+  0x80, SSD1306_SET_PAGE_ADDR, 0x80, 0, 0x80, (pages) - 1, 0x40
+
+// Largest panel a display handle can drive: 128 columns by 8 pages (128x64)
+#define SSD1306_MAX_WIDTH 128
+#define SSD1306_MAX_PAGES 8
+
+// Longest command list sent in a single transaction by SSD1306_send_cmd_list()
+#define SSD1306_CMD_STREAM_MAX 32
+
 #define SSD1306_WRITE_MODE _u(0xFE)
 #define SSD1306_READ_MODE _u(0xFF)
 
@@ -84,4 +138,60 @@ struct render_area
   int buflen;
 };
 
+// Completion callback for render_async(), ok is false if the panel did not ACK
+typedef void (*ssd1306_flush_cb)(bool ok);
+
+struct i2c_inst;
+
+// One panel: where it sits on the bus, its geometry and its frame buffer, plus
+// the damage and flush state the driver keeps for it. Set up with ssd1306_setup();
+// the SSD1306_* functions, render() and friends drive the board's own display,
+// whose geometry is the compile-time SSD1306_WIDTH x SSD1306_HEIGHT.
+typedef struct
+{
+  struct i2c_inst *i2c;
+  uint8_t addr;
+  uint8_t width;
+  uint8_t height;
+  uint8_t pages;
+  uint8_t *buf;       // pixel data, SSD1306_BUF_PREFIX bytes into the frame
+  uint16_t *flush_tx; // SSD1306_FRAME_LEN_FOR(width, height) words, for DMA flushes
+
+  // modified column span [start, end) of each page since the last flush
+  uint8_t dirty_start[SSD1306_MAX_PAGES];
+  uint8_t dirty_end[SSD1306_MAX_PAGES];
+
+  int8_t scroll_page0, scroll_page1; // pages under a horizontal scroll; page0 > page1 when stopped
+  int dma_chan;
+  volatile bool flush_busy;
+  uint16_t flush_len;          // words in flush_tx, kept to resend after a fallback
+  uint32_t flush_deadline_us;  // time_us_32() by which the flush must be done
+  uint32_t flush_t0;           // trace span of the flush in flight, see trace.h
+  ssd1306_flush_cb flush_cb;
+} ssd1306_t;
+
+// How BlitBitmap() combines source bits with the frame buffer. Bitmaps use the
+// display layout: one byte per column per 8-row page, LSB on top.
+enum ssd1306_blit_op
+{
+  SSD1306_BLIT_COPY,  // covered rows take the source bits
+  SSD1306_BLIT_OR,    // set pixels where the source is set
+  SSD1306_BLIT_CLEAR, // clear pixels where the source is set
+  SSD1306_BLIT_XOR    // invert pixels where the source is set
+};
+
+// Font atlas in flash, generated at build time from fonts/*.txt by
+// tools/fontgen.py. map[] takes a Latin-1 code point straight to a glyph index;
+// unmapped code points use glyph 0, the blank.
+typedef struct
+{
+  const uint8_t *bitmap;  // glyph columns in display layout, back to back
+  const uint16_t *offset; // proportional fonts: first column of glyph i, num_glyphs + 1 entries
+  const uint8_t *map;     // 256 entries
+  uint8_t width;          // fixed width fonts: columns per glyph, spacing included
+  uint8_t spacing;        // proportional fonts: blank columns after each glyph
+  uint8_t height;
+  uint8_t num_glyphs;
+} ssd1306_font_t;
+
 #endif /* _SSD1306_I2C_H_ */
\ No newline at end of file
@@ -0,0 +1,45 @@
+#include "pico/stdlib.h"
+#include "hardware/pwm.h"
+#include "tone.h"
+
+static uint voice_pins[TONE_VOICES];
+static uint num_voices = 0;
+
+// Configura uma voz por pino (até TONE_VOICES), todas em silêncio
+void tone_init(const uint *pins, uint count, float clkdiv) {
+    if (count > TONE_VOICES)
+        count = TONE_VOICES;
+
+    for (uint i = 0; i < count; i++) {
+        voice_pins[i] = pins[i];
+        gpio_set_function(pins[i], GPIO_FUNC_PWM);
+        pwm_set_clkdiv(pwm_gpio_to_slice_num(pins[i]), clkdiv);
+    }
+    num_voices = count;
+}
+
+// Voz que toca no pino, -1 se nenhuma
+int tone_voice(uint pin) {
+    for (uint i = 0; i < num_voices; i++) {
+        if (voice_pins[i] == pin)
+            return i;
+    }
+    return -1;
+}
+
+// Toca na voz a nota de período wrap, com o pino em nível alto por level ciclos
+// (o volume). wrap ou level 0 silencia. Pode ser chamada de IRQs.
+void tone_set(uint voice, uint16_t wrap, uint16_t level) {
+    if (voice >= num_voices)
+        return;
+
+    uint pin = voice_pins[voice];
+    uint slice = pwm_gpio_to_slice_num(pin);
+    if (wrap && level) {
+        pwm_set_wrap(slice, wrap);
+        pwm_set_gpio_level(pin, level);
+        pwm_set_enabled(slice, true);
+    } else {
+        pwm_set_enabled(slice, false);
+    }
+}
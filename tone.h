@@ -0,0 +1,16 @@
+#ifndef TONE_H_
+#define TONE_H_
+
+#include "pico/stdlib.h"
+
+// Gerador de tons com uma voz por buzzer: cada voz é o PWM do pino, na fatia
+// dele, então as duas tocam ao mesmo tempo sem a CPU marcar tempo. As notas
+// são dadas em valores de wrap do PWM (notes.h).
+
+#define TONE_VOICES 2
+
+extern void tone_init(const uint *pins, uint count, float clkdiv);
+extern int tone_voice(uint pin);
+extern void tone_set(uint voice, uint16_t wrap, uint16_t level);
+
+#endif /* TONE_H_ */
@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+"""Pull the attendance log off a BitDogLab over USB (binary export, export.h).
+
+Usage: attendance_export.py [--cursor SEQ] [--state FILE] [--out FILE] [--retries N] PORT
+       attendance_export.py --capture FILE [--out FILE]
+
+PORT is the board's CDC device, e.g. /dev/ttyACM0. Records are written as CSV
+(seq,boot,timestamp_ms,session,type) to --out, or stdout. With --state the
+cursor is read from and saved to FILE after every good batch, so an interrupted
+transfer resumes where it stopped and later runs only fetch new records. A
+batch with a bad CRC-32 is dropped and the export asked again from the cursor.
+--capture decodes a stream saved to a file instead (e.g. BITDOGLAB_SIM_USB_OUT).
+"""
+import argparse
+import os
+import select
+import struct
+import sys
+import termios
+import time
+import tty
+import zlib
+
+MAGIC = 0xA7
+BATCH = 1
+END = 2
+HEADER = struct.Struct("<BBHI")
+RECORD = struct.Struct("<IIIHBB")
+TIMEOUT_S = 3.0
+
+
+class Stream:
+    """Byte source with a read timeout, over a tty or a capture file."""
+
+    def __init__(self, fd, is_tty):
+        self.fd = fd
+        self.is_tty = is_tty
+        self.buf = bytearray()
+
+    def read(self, n):
+        deadline = time.monotonic() + TIMEOUT_S
+        while len(self.buf) < n:
+            if self.is_tty:
+                left = deadline - time.monotonic()
+                if left <= 0 or not select.select([self.fd], [], [], left)[0]:
+                    return None
+            chunk = os.read(self.fd, 65536)
+            if not chunk:
+                return None
+            self.buf += chunk
+        out = bytes(self.buf[:n])
+        del self.buf[:n]
+        return out
+
+
+def crc8(data):
+    crc = 0
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else crc << 1
+    return crc
+
+
+def frames(stream):
+    """Yields (kind, cursor, payload, crc_ok); resyncs on the magic byte."""
+    while True:
+        b = stream.read(1)
+        if b is None:
+            return
+        if b[0] != MAGIC:
+            continue
+        rest = stream.read(HEADER.size - 1)
+        if rest is None:
+            return
+        head = b + rest
+        _, kind, length, cursor = HEADER.unpack(head)
+        if kind not in (BATCH, END) or length % RECORD.size:
+            continue
+        body = stream.read(length + 4)
+        if body is None:
+            return
+        payload, (crc,) = body[:length], struct.unpack("<I", body[length:])
+        yield kind, cursor, payload, zlib.crc32(head + payload) == crc
+
+
+def records(payload):
+    for i in range(0, len(payload), RECORD.size):
+        raw = payload[i:i + RECORD.size]
+        if raw == b"\xff" * RECORD.size:
+            continue  # slot erased while the batch was being sent
+        if crc8(raw[:-1]) != raw[-1]:
+            print(f"warning: record with bad CRC-8 skipped (seq field {RECORD.unpack(raw)[0]})", file=sys.stderr)
+            continue
+        yield RECORD.unpack(raw)[:5]
+
+
+def export(stream, cursor, out, save):
+    """Reads one export; returns (next cursor, records, bytes, complete)."""
+    count = nbytes = 0
+    for kind, first, payload, ok in frames(stream):
+        nbytes += HEADER.size + len(payload) + 4
+        if not ok:
+            print(f"warning: batch at seq {first} failed its CRC-32", file=sys.stderr)
+            return cursor, count, nbytes, False
+        if kind == END:
+            save(first)
+            return first, count, nbytes, True
+        for seq, boot, ts, session, typ in records(payload):
+            if seq < cursor:
+                continue  # already have it
+            out.write(f"{seq},{boot},{ts},{session},{typ}\n")
+            cursor = seq + 1
+            count += 1
+        out.flush()
+        save(cursor)
+    return cursor, count, nbytes, False
+
+
+def open_port(path):
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+    tty.setraw(fd)
+    termios.tcflush(fd, termios.TCIOFLUSH)
+    return fd
+
+
+def drain(stream):
+    """Drops whatever is left of an interrupted export (until the line is quiet)."""
+    while stream.read(1) is not None:
+        pass
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("port", nargs="?")
+    ap.add_argument("--capture")
+    ap.add_argument("--cursor", type=int, default=None)
+    ap.add_argument("--state")
+    ap.add_argument("--out")
+    ap.add_argument("--retries", type=int, default=3)
+    args = ap.parse_args()
+    if bool(args.port) == bool(args.capture):
+        ap.error("give either PORT or --capture")
+
+    cursor = args.cursor
+    if cursor is None and args.state and os.path.exists(args.state):
+        with open(args.state) as f:
+            cursor = int(f.read().strip() or 0)
+    cursor = cursor or 0
+
+    def save(c):
+        if args.state:
+            with open(args.state + ".tmp", "w") as f:
+                f.write(f"{c}\n")
+            os.replace(args.state + ".tmp", args.state)
+
+    out = open(args.out, "a" if args.state else "w") if args.out else sys.stdout
+    t0 = time.monotonic()
+    total = total_bytes = 0
+
+    if args.capture:
+        with open(args.capture, "rb") as f:
+            cursor, total, total_bytes, done = export(Stream(f.fileno(), False), cursor, out, save)
+    else:
+        fd = open_port(args.port)
+        stream = Stream(fd, True)
+        for attempt in range(args.retries + 1):
+            os.write(fd, b"x%08X" % cursor)
+            cursor, n, nbytes, done = export(stream, cursor, out, save)
+            total += n
+            total_bytes += nbytes
+            if done:
+                break
+            drain(stream)
+        os.close(fd)
+
+    dt = time.monotonic() - t0
+    rate = total_bytes / dt / 1024 if dt > 0 and not args.capture else 0
+    print(f"{total} records, {total_bytes} bytes, {dt:.2f} s ({rate:.0f} KiB/s), next cursor {cursor}"
+          + ("" if done else ", INCOMPLETE"), file=sys.stderr)
+    sys.exit(0 if done else 1)
+
+
+if __name__ == "__main__":
+    main()
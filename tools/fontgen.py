@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""Compile a text font description into SSD1306 font atlases.
+
+Usage: fontgen.py SOURCE OUT_C OUT_H NAME:fixed|proportional...
+
+Each NAME becomes a const ssd1306_font_t in flash. Glyph bitmaps use the display
+layout (one byte per column, LSB on top) and a 256-entry table maps Latin-1 code
+points straight to a glyph index, so lookups are O(1).
+"""
+import sys
+
+HEIGHT = 8
+PROPORTIONAL_SPACING = 1
+PROPORTIONAL_BLANK_WIDTH = 3
+
+
+def parse(path):
+    glyphs = []  # (code point, [column bytes])
+    with open(path, encoding="utf-8") as f:
+        lines = [l.rstrip("\n") for l in f]
+
+    i = 0
+    while i < len(lines):
+        line = lines[i].strip()
+        i += 1
+        if not line or line.startswith("#"):
+            continue
+        if not line.startswith("glyph "):
+            sys.exit(f"{path}:{i}: expected 'glyph', got '{line}'")
+
+        name = line[len("glyph "):].strip()
+        cp = int(name[2:], 16) if name.startswith("U+") else ord(name)
+        if len(name) != 1 and not name.startswith("U+"):
+            sys.exit(f"{path}:{i}: bad glyph name '{name}'")
+        if cp > 0xFF:
+            sys.exit(f"{path}:{i}: U+{cp:04X} is outside Latin-1")
+
+        rows = lines[i:i + HEIGHT]
+        if len(rows) != HEIGHT or any(len(r) != len(rows[0]) for r in rows):
+            sys.exit(f"{path}:{i}: glyph '{name}' needs {HEIGHT} rows of equal width")
+        i += HEIGHT
+
+        cols = [sum(1 << r for r in range(HEIGHT) if rows[r][c] == "#") for c in range(len(rows[0]))]
+        glyphs.append((cp, cols))
+
+    if not glyphs or glyphs[0][0] != 0x20:
+        sys.exit(f"{path}: the first glyph must be the blank U+0020")
+    return glyphs
+
+
+def build_map(glyphs):
+    index = {cp: i for i, (cp, _) in enumerate(glyphs)}
+    table = []
+    for cp in range(256):
+        if cp not in index and len(chr(cp).upper()) == 1:
+            cp = ord(chr(cp).upper())  # a, ã, ç... share the capital glyph
+        table.append(index.get(cp, 0))
+    return table
+
+
+def trim(cols):
+    lit = [c for c, v in enumerate(cols) if v]
+    if not lit:
+        return [0] * PROPORTIONAL_BLANK_WIDTH
+    return cols[lit[0]:lit[-1] + 1]
+
+
+def hex_bytes(values, per_line=16):
+    out = []
+    for i in range(0, len(values), per_line):
+        out.append("    " + " ".join(f"0x{v:02x}," for v in values[i:i + per_line]))
+    return "\n".join(out)
+
+
+def emit_font(name, kind, glyphs, table):
+    width = len(glyphs[0][1])
+    out = [f"// {kind} width, {len(glyphs)} glyphs"]
+
+    if kind == "fixed":
+        if any(len(cols) != width for _, cols in glyphs):
+            sys.exit(f"{name}: all glyphs of a fixed font must be {width} columns wide")
+        bitmap = [b for _, cols in glyphs for b in cols]
+        offsets = None
+    else:
+        bitmap, offsets = [], []
+        for _, cols in glyphs:
+            offsets.append(len(bitmap))
+            bitmap += trim(cols)
+        offsets.append(len(bitmap))
+
+    out.append(f"static const uint8_t {name}_bitmap[{len(bitmap)}] = {{")
+    out.append(hex_bytes(bitmap))
+    out.append("};")
+    if offsets:
+        out.append(f"static const uint16_t {name}_offset[{len(offsets)}] = {{")
+        out.append("    " + " ".join(f"{o}," for o in offsets))
+        out.append("};")
+    out.append(f"static const uint8_t {name}_map[256] = {{")
+    out.append(hex_bytes(table))
+    out.append("};")
+    out.append(f"const ssd1306_font_t {name} = {{")
+    out.append(f"    .bitmap = {name}_bitmap,")
+    out.append(f"    .offset = {name + '_offset' if offsets else 'NULL'},")
+    out.append(f"    .map = {name}_map,")
+    out.append(f"    .width = {width},")
+    out.append(f"    .spacing = {PROPORTIONAL_SPACING if offsets else 0},")
+    out.append(f"    .height = {HEIGHT},")
+    out.append(f"    .num_glyphs = {len(glyphs)},")
+    out.append("};")
+    return "\n".join(out), len(bitmap) + (2 * len(offsets) if offsets else 0) + len(table)
+
+
+def main():
+    if len(sys.argv) < 5:
+        sys.exit(__doc__)
+    source, out_c, out_h = sys.argv[1:4]
+    fonts = [arg.split(":") for arg in sys.argv[4:]]
+    if any(len(f) != 2 or f[1] not in ("fixed", "proportional") for f in fonts):
+        sys.exit(__doc__)
+
+    glyphs = parse(source)
+    if len(glyphs) > 256:
+        sys.exit(f"{source}: at most 256 glyphs")
+    table = build_map(glyphs)
+
+    guard = "SSD1306_FONTS_H_"
+    banner = "// Generated by tools/fontgen.py from fonts/%s. Do not edit." % source.replace("\\", "/").split("/")[-1]
+
+    body, header = [banner, '#include "ssd1306_fonts.h"', ""], [banner, f"#ifndef {guard}", f"#define {guard}", "",
+                                                                  '#include <stddef.h>', '#include <stdint.h>',
+                                                                  '#include <stdbool.h>', '#include "ssd1306_i2c.h"', ""]
+    for name, kind in fonts:
+        text, size = emit_font(name, kind, glyphs, table)
+        body += [text, ""]
+        header.append(f"extern const ssd1306_font_t {name};  // {size} bytes")
+    header += ["", "#endif", ""]
+
+    with open(out_c, "w", encoding="utf-8") as f:
+        f.write("\n".join(body))
+    with open(out_h, "w", encoding="utf-8") as f:
+        f.write("\n".join(header))
+
+
+if __name__ == "__main__":
+    main()
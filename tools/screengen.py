@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+"""Rasterize fixed text screens into SSD1306 frames at build time.
+
+Usage: screengen.py FONT SOURCE OUT_C OUT_H
+
+FONT is the fixed 8x8 font description read by fontgen.py. SOURCE holds one
+block per screen: "screen <name>", then one quoted line of text per display
+line. Each <name> becomes a const uint8_t[SSD1306_FRAME_LEN] in flash, laid out
+exactly as display_text() would draw the lines, with the full panel window
+header already in front of the pixels so render_frame() sends it untouched.
+"""
+import os
+import re
+import sys
+
+sys.dont_write_bytecode = True  # keep the source tree clean
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from fontgen import parse as parse_font, build_map  # noqa: E402
+
+WIDTH = 128
+HEIGHT = 32
+PAGES = HEIGHT // 8
+CELL = 8       # WriteString() advance
+TEXT_X = 5     # left margin used by display_text()
+
+
+def parse(path):
+    screens = []  # (name, [lines])
+    with open(path, encoding="utf-8") as f:
+        for i, raw in enumerate(f, 1):
+            line = raw.strip()
+            if not line or line.startswith("#"):
+                continue
+            m = re.fullmatch(r"screen\s+([A-Za-z_]\w*)", line)
+            if m:
+                screens.append((m.group(1), []))
+                continue
+            m = re.fullmatch(r'"(.*)"', line)
+            if not m or not screens:
+                sys.exit(f"{path}:{i}: expected 'screen <name>' or a quoted line, got '{line}'")
+            if len(screens[-1][1]) == PAGES:
+                sys.exit(f"{path}:{i}: screen '{screens[-1][0]}' has more than {PAGES} lines")
+            screens[-1][1].append(m.group(1))
+    if not screens:
+        sys.exit(f"{path}: no screens")
+    return screens
+
+
+def rasterize(lines, glyphs, table):
+    """Same pixels as WriteString(buf, TEXT_X, 8 * i, lines[i]) on a blank buffer."""
+    buf = [0] * (WIDTH * PAGES)
+    for page, text in enumerate(lines):
+        x = TEXT_X
+        for ch in text:
+            cp = ord(ch)
+            if x <= WIDTH - CELL:
+                cols = glyphs[table[cp] if cp <= 0xFF else 0][1]
+                buf[page * WIDTH + x:page * WIDTH + x + CELL] = cols[:CELL]
+            x += CELL
+    return buf
+
+
+def main():
+    if len(sys.argv) != 5:
+        sys.exit(__doc__)
+    font, source, out_c, out_h = sys.argv[1:]
+
+    glyphs = parse_font(font)
+    if any(len(cols) != CELL for _, cols in glyphs):
+        sys.exit(f"{font}: screens need a fixed {CELL} column font")
+    table = build_map(glyphs)
+    screens = parse(source)
+    banner = f"// Generated by tools/screengen.py from screens/{os.path.basename(source)}, do not edit."
+
+    with open(out_h, "w", encoding="utf-8") as f:
+        f.write(banner + "\n")
+        f.write("#ifndef SCREENS_H_\n#define SCREENS_H_\n\n#include \"pico/stdlib.h\"\n#include \"ssd1306_i2c.h\"\n\n")
+        for name, _ in screens:
+            f.write(f"extern const uint8_t {name}[SSD1306_FRAME_LEN];\n")
+        f.write("\n#endif /* SCREENS_H_ */\n")
+
+    with open(out_c, "w", encoding="utf-8") as f:
+        f.write(banner + "\n")
+        f.write("#include \"screens.h\"\n\n")
+        f.write(f"_Static_assert(SSD1306_WIDTH == {WIDTH} && SSD1306_HEIGHT == {HEIGHT},\n"
+                f"               \"screens are rasterized for a {WIDTH}x{HEIGHT} panel\");\n")
+        for name, lines in screens:
+            pixels = rasterize(lines, glyphs, table)
+            f.write("\n")
+            for text in lines:
+                f.write(f"// \"{text}\"\n")
+            f.write(f"const uint8_t {name}[SSD1306_FRAME_LEN] = {{\n")
+            f.write("    SSD1306_FRAME_HDR(SSD1306_WIDTH, SSD1306_NUM_PAGES),\n")
+            for i in range(0, len(pixels), 16):
+                f.write("    " + " ".join(f"0x{v:02x}," for v in pixels[i:i + 16]) + "\n")
+            f.write("};\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+"""Convert parallel note/duration tables into the packed song format of song.h.
+
+Usage: songgen.py OUT_C OUT_H NAME=SOURCE:WHOLE_MS...
+
+Each SOURCE holds two C arrays, the notes (NOTE_* names from notes.h, or 0 for
+a rest) and the figures (1 = whole note, 2 = half, 4 = quarter, ...), in that
+order. NAME becomes a const uint16_t array in flash: a tempo word, the notes,
+SONG_END. Runs of a block repeated back to back are folded into loop markers.
+"""
+import os
+import re
+import sys
+
+MAX_LOOP_BLOCK = 32   # longest block searched for repeats
+MAX_LOOP_TIMES = 0xFFF
+
+
+def parse(path):
+    with open(path, encoding="utf-8") as f:
+        text = re.sub(r"//[^\n]*|/\*.*?\*/", "", f.read(), flags=re.S)
+
+    arrays = re.findall(r"\[\s*\]\s*=\s*\{(.*?)\}", text, flags=re.S)
+    if len(arrays) != 2:
+        sys.exit(f"{path}: expected two arrays (notes, figures), found {len(arrays)}")
+    notes, figures = ([v.strip() for v in a.split(",") if v.strip()] for a in arrays)
+    if len(notes) != len(figures):
+        sys.exit(f"{path}: {len(notes)} notes but {len(figures)} figures")
+
+    events = []
+    for i, (note, fig) in enumerate(zip(notes, figures)):
+        if note == "0":
+            pitch = "PITCH_REST"
+        elif re.fullmatch(r"NOTE_\w+", note):
+            pitch = "PITCH_" + note[len("NOTE_"):]
+        else:
+            sys.exit(f"{path}: note {i} '{note}' is not a NOTE_* name or 0")
+        if not fig.isdigit() or not 1 <= int(fig) <= 255:
+            sys.exit(f"{path}: figure {i} '{fig}' is not in 1..255")
+        events.append((pitch, int(fig)))
+    return events
+
+
+def best_loop(events, i):
+    """Block length and repeat count at i that save the most words, or None."""
+    best, best_saved = None, 0
+    for length in range(1, min(MAX_LOOP_BLOCK, (len(events) - i) // 2) + 1):
+        block = events[i:i + length]
+        times = 1
+        while (times < MAX_LOOP_TIMES and
+               events[i + times * length:i + (times + 1) * length] == block):
+            times += 1
+        saved = (times - 1) * length - 2  # the two markers cost a word each
+        if times > 1 and saved > best_saved:
+            best, best_saved = (length, times), saved
+    return best
+
+
+def pack(events, whole_ms):
+    words = [f"SONG_TEMPO({whole_ms})"]
+    i = 0
+    while i < len(events):
+        loop = best_loop(events, i)
+        if loop:
+            length, times = loop
+            words.append("SONG_LOOP_START")
+            words += [f"SONG_NOTE({p}, {f})" for p, f in events[i:i + length]]
+            words.append(f"SONG_LOOP_END({times})")
+            i += length * times
+        else:
+            p, f = events[i]
+            words.append(f"SONG_NOTE({p}, {f})")
+            i += 1
+    words.append("SONG_END")
+    return words
+
+
+def main():
+    if len(sys.argv) < 4:
+        sys.exit(__doc__)
+    out_c, out_h = sys.argv[1:3]
+
+    songs = []
+    for arg in sys.argv[3:]:
+        m = re.fullmatch(r"(\w+)=(.+):(\d+)", arg)
+        if not m or not 1 <= int(m.group(3)) <= 0xFFF:
+            sys.exit(f"bad song '{arg}', expected NAME=SOURCE:WHOLE_MS (1..4095 ms)")
+        name, path, whole_ms = m.group(1), m.group(2), int(m.group(3))
+        events = parse(path)
+        songs.append((name, path, len(events), pack(events, whole_ms)))
+
+    with open(out_h, "w", encoding="utf-8") as f:
+        f.write("// Generated by tools/songgen.py, do not edit.\n")
+        f.write("#ifndef SONGS_H_\n#define SONGS_H_\n\n#include \"song.h\"\n\n")
+        for name, _, _, words in songs:
+            f.write(f"extern const uint16_t {name}[{len(words)}];\n")
+        f.write("\n#endif /* SONGS_H_ */\n")
+
+    with open(out_c, "w", encoding="utf-8") as f:
+        f.write("// Generated by tools/songgen.py, do not edit.\n")
+        f.write("#include \"songs.h\"\n")
+        for name, path, count, words in songs:
+            f.write(f"\n// {os.path.basename(path)}: {count} notes in {len(words)} words\n")
+            f.write(f"const uint16_t {name}[{len(words)}] = {{\n")
+            for w in words:
+                f.write(f"    {w},\n")
+            f.write("};\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#include "trace.h"
+
+volatile bool trace_on = false;
+
+static const char *const probe_names[TRACE_NUM_PROBES] = {
+#define TRACE_NAME(id, name) name,
+    TRACE_PROBES(TRACE_NAME)
+#undef TRACE_NAME
+};
+
+// Estado de um núcleo: só ele escreve em head, stats e dropped; o leitor
+// (trace_read, no núcleo 0) só escreve em tail
+typedef struct {
+    trace_record ring[TRACE_RING_LEN];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    uint32_t dropped;
+    trace_stat stats[TRACE_NUM_PROBES];
+} trace_core;
+
+static trace_core cores[2];
+static trace_report_fn report_fn;  // Linhas extras de outro módulo no comando 's'
+static trace_input_fn input_fn;    // Recebe os caracteres que não são comandos daqui
+
+// Fecha um intervalo aberto com TRACE_BEGIN
+void trace_span(trace_probe probe, uint32_t t0) {
+    t0 &= ~1u;  // Desfaz a marca de TRACE_BEGIN
+    uint32_t dur = time_us_32() - t0;
+    uint core_num = get_core_num();
+    trace_core *c = &cores[core_num];
+    trace_stat *st = &c->stats[probe];
+
+    st->count++;
+    st->total_us += dur;
+    if (dur > st->max_us)
+        st->max_us = dur;
+
+    uint32_t head = c->head;
+    if (head - c->tail >= TRACE_RING_LEN) {
+        c->dropped++;  // Fila cheia: o registro se perde, as estatísticas não
+        return;
+    }
+    c->ring[head % TRACE_RING_LEN] = (trace_record){
+        .start_us = t0,
+        .dur_us = dur > UINT16_MAX ? UINT16_MAX : dur,
+        .probe = probe,
+        .core = core_num,
+    };
+    __dmb();  // O registro fica visível antes do novo head
+    c->head = head + 1;
+}
+
+void trace_count(trace_probe probe) {
+    cores[get_core_num()].stats[probe].count++;
+}
+
+void trace_enable(bool on) {
+    trace_on = on;
+}
+
+// Descarta registros pendentes e zera as estatísticas. As estatísticas do outro
+// núcleo podem perder uma atualização concorrente, o que não importa aqui.
+void trace_clear(void) {
+    for (uint i = 0; i < count_of(cores); i++) {
+        cores[i].tail = cores[i].head;
+        cores[i].dropped = 0;
+        memset(cores[i].stats, 0, sizeof(cores[i].stats));
+    }
+}
+
+// Estatísticas somadas dos dois núcleos
+void trace_get_stat(trace_probe probe, trace_stat *stat) {
+    memset(stat, 0, sizeof(*stat));
+    for (uint i = 0; i < count_of(cores); i++) {
+        const trace_stat *st = &cores[i].stats[probe];
+        stat->count += st->count;
+        stat->total_us += st->total_us;
+        if (st->max_us > stat->max_us)
+            stat->max_us = st->max_us;
+    }
+}
+
+// Retira até max registros das filas, primeiro os do núcleo 0
+uint trace_read(trace_record *out, uint max) {
+    uint n = 0;
+
+    for (uint i = 0; i < count_of(cores); i++) {
+        trace_core *c = &cores[i];
+        uint32_t tail = c->tail;
+        uint32_t head = c->head;
+
+        __dmb();  // Lê os registros só depois de ver o head
+        while (tail != head && n < max)
+            out[n++] = c->ring[tail++ % TRACE_RING_LEN];
+        c->tail = tail;
+    }
+    return n;
+}
+
+uint32_t trace_dropped(void) {
+    return cores[0].dropped + cores[1].dropped;
+}
+
+// Acrescenta ao comando 's' o relatório de outro módulo (um só)
+void trace_set_report(trace_report_fn fn) {
+    report_fn = fn;
+}
+
+// Repassa a outro módulo (um só) os caracteres do console que o trace ignora,
+// para comandos próprios com parâmetros
+void trace_set_input(trace_input_fn fn) {
+    input_fn = fn;
+}
+
+const char *trace_probe_name(trace_probe probe) {
+    return probe < TRACE_NUM_PROBES ? probe_names[probe] : "?";
+}
+
+// Uma linha por ponto com atividade:
+//   S <nome> count=<n> total_us=<t> max_us=<m>
+static void print_stats(void) {
+    for (uint i = 0; i < TRACE_NUM_PROBES; i++) {
+        trace_stat st;
+        trace_get_stat(i, &st);
+        if (st.count)
+            printf("S %s count=%lu total_us=%lu max_us=%lu\n", probe_names[i], (unsigned long)st.count,
+                   (unsigned long)st.total_us, (unsigned long)st.max_us);
+    }
+    printf("S dropped=%lu\n", (unsigned long)trace_dropped());
+    if (report_fn)
+        report_fn();
+}
+
+// Uma linha por intervalo registrado: E <núcleo> <início_us> <nome> <duração_us>
+static void print_records(void) {
+    trace_record rec[16];
+    uint n;
+
+    while ((n = trace_read(rec, count_of(rec))))
+        for (uint i = 0; i < n; i++)
+            printf("E %u %lu %s %u\n", rec[i].core, (unsigned long)rec[i].start_us,
+                   trace_probe_name(rec[i].probe), rec[i].dur_us);
+}
+
+// Comandos de um caractere pela USB: '+' liga, '-' desliga, 's' estatísticas
+// (seguidas do relatório de trace_set_report), 'r' registros pendentes, 'c'
+// zera tudo. Cada resposta termina com "OK".
+void trace_poll(void) {
+    int ch;
+
+    while ((ch = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT) {
+        switch (ch) {
+            case '+':
+                trace_enable(true);
+                break;
+            case '-':
+                trace_enable(false);
+                break;
+            case 's':
+                print_stats();
+                break;
+            case 'r':
+                print_records();
+                break;
+            case 'c':
+                trace_clear();
+                break;
+            default:
+                if (input_fn)
+                    input_fn(ch);
+                continue;  // Fim de linha e afins, ou comando de outro módulo
+        }
+        printf("OK\n");
+    }
+}
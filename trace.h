@@ -0,0 +1,89 @@
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include "pico/stdlib.h"
+
+// Instrumentação leve: contadores e intervalos de tempo com nome. Cada núcleo
+// grava os seus numa fila circular própria (um produtor, um consumidor, sem
+// travas), que é esvaziada sob pedido pela USB. Com TRACE_ENABLED=0 os pontos
+// somem do binário, mas os comandos da USB e o relatório de trace_set_report
+// continuam; compilados mas desligados, custam a leitura de uma flag.
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+#define TRACE_RING_LEN 256  // Registros por núcleo (potência de 2)
+#define TRACE_POLL_MS 50    // Intervalo de leitura dos comandos pela USB
+
+// Pontos de medição: identificador e nome usado na saída
+#define TRACE_PROBES(X)                   \
+    X(RENDER, "render")                   \
+    X(RENDER_DIRTY, "render_dirty")       \
+    X(RENDER_ASYNC, "render_async")       \
+    X(RENDER_FRAME, "render_frame")       \
+    X(SEND_BUF, "send_buf")               \
+    X(READ_BUTTONS, "read_buttons")       \
+    X(READ_JOYSTICK, "read_joystick")     \
+    X(ALERT_SOUND, "play_alert_sound")    \
+    X(I2C_FALLBACK, "i2c_fallback")
+
+typedef enum {
+#define TRACE_ENUM(id, name) TRACE_##id,
+    TRACE_PROBES(TRACE_ENUM)
+#undef TRACE_ENUM
+    TRACE_NUM_PROBES
+} trace_probe;
+
+// Um intervalo medido; contadores não geram registros
+typedef struct {
+    uint32_t start_us;  // time_us_32 no início
+    uint16_t dur_us;    // Saturado em 65535
+    uint8_t probe;      // trace_probe
+    uint8_t core;
+} trace_record;
+
+typedef struct {
+    uint32_t count;
+    uint32_t total_us;
+    uint32_t max_us;
+} trace_stat;
+
+typedef void (*trace_report_fn)(void);
+typedef void (*trace_input_fn)(int ch);
+
+extern volatile bool trace_on;
+
+#if TRACE_ENABLED
+// Início de um intervalo. Desligado dá 0, e o fim correspondente não faz nada;
+// ligado, o bit 0 é forçado para que o instante nunca seja 0.
+#define TRACE_BEGIN() (trace_on ? time_us_32() | 1 : 0)
+#define TRACE_END(id, t0)                   \
+    do {                                    \
+        if (t0)                             \
+            trace_span(TRACE_##id, (t0));   \
+    } while (0)
+#define TRACE_COUNT(id)                     \
+    do {                                    \
+        if (trace_on)                       \
+            trace_count(TRACE_##id);        \
+    } while (0)
+#else
+#define TRACE_BEGIN() 0u
+#define TRACE_END(id, t0) ((void)(t0))
+#define TRACE_COUNT(id) ((void)0)
+#endif
+
+extern void trace_span(trace_probe probe, uint32_t t0);
+extern void trace_count(trace_probe probe);
+extern void trace_enable(bool on);
+extern void trace_clear(void);
+extern void trace_get_stat(trace_probe probe, trace_stat *stat);
+extern uint trace_read(trace_record *out, uint max);
+extern uint32_t trace_dropped(void);
+extern const char *trace_probe_name(trace_probe probe);
+extern void trace_set_report(trace_report_fn fn);
+extern void trace_set_input(trace_input_fn fn);
+extern void trace_poll(void);
+
+#endif /* TRACE_H_ */